@@ -0,0 +1,139 @@
+/*
+ * batch.cpp:
+ * build the vertex arrays of a render_batch
+ */
+
+#include <algorithm>
+
+#include "batch.hpp"
+
+namespace {
+
+	// glyph quads are grown by a pixel each way, as sf::Text does, so their antialiased edges aren't cut
+	const float glyph_padding = 1.0f;
+
+	// two triangles covering (left, top) to (right, bottom), mapped by transform and textured from tex
+	void quad(sf::VertexArray& to, const sf::Transform& transform, const sf::Color& colour,
+			float left, float top, float right, float bottom, const sf::FloatRect& tex=sf::FloatRect()) {
+		sf::Vertex corners[4] = {
+			sf::Vertex(transform.transformPoint(sf::Vector2f(left, top)), colour, sf::Vector2f(tex.left, tex.top)),
+			sf::Vertex(transform.transformPoint(sf::Vector2f(right, top)), colour, sf::Vector2f(tex.left + tex.width, tex.top)),
+			sf::Vertex(transform.transformPoint(sf::Vector2f(left, bottom)), colour, sf::Vector2f(tex.left, tex.top + tex.height)),
+			sf::Vertex(transform.transformPoint(sf::Vector2f(right, bottom)), colour, sf::Vector2f(tex.left + tex.width, tex.top + tex.height))
+		};
+
+		for (auto i : { 0, 1, 2, 2, 1, 3 })
+			to.append(corners[i]);
+	}
+};
+
+render_batch::render_batch()
+	: _rects(sf::Triangles), _built(_changes() - 1) {
+}
+
+void render_batch::clear() {
+	_rects.clear();
+
+	for (auto& p : _glyphs)
+		p.second.clear();
+
+	_built = _changes();
+}
+
+void render_batch::add(const sf::RectangleShape& shape) {
+	const auto& transform = shape.getTransform();
+	float w = shape.getSize().x, h = shape.getSize().y;
+
+	quad(_rects, transform, shape.getFillColor(), 0.0f, 0.0f, w, h);
+
+	// the outline is the ring between the shape and the shape grown by the thickness, shrunk when it is negative
+	float t = shape.getOutlineThickness();
+	if (t == 0.0f)
+		return;
+
+	float out = std::max(t, 0.0f), in = std::max(-t, 0.0f);
+	const auto& colour = shape.getOutlineColor();
+
+	quad(_rects, transform, colour, -out, -out, w + out, in); // top
+	quad(_rects, transform, colour, -out, h - in, w + out, h + out); // bottom
+	quad(_rects, transform, colour, -out, in, in, h - in); // left
+	quad(_rects, transform, colour, w - in, in, w + out, h - in); // right
+}
+
+// the layout of sf::Text::ensureGeometryUpdate() for regular text with default spacing
+void render_batch::add(const sf::Text& text) {
+	const sf::Font* font = text.getFont();
+	const sf::String& string = text.getString();
+
+	if (!font || string.getSize() == 0)
+		return;
+
+	unsigned int size = text.getCharacterSize();
+	const auto& transform = text.getTransform();
+	const auto& colour = text.getFillColor();
+
+	float whitespace = font->getGlyph(L' ', size, false).advance;
+	float line = font->getLineSpacing(size);
+
+	// the pen starts on the baseline of the first line
+	float x = 0.0f, y = static_cast<float>(size);
+	sf::Uint32 previous = 0;
+
+	// the texture of size, which keeps its address as the glyphs below are added to it
+	auto& page = _page(&font->getTexture(size));
+
+	for (std::size_t i = 0; i < string.getSize(); i++) {
+		sf::Uint32 c = string[i];
+
+		x += font->getKerning(previous, c, size);
+		previous = c;
+
+		// whitespace only moves the pen
+		if (c == L' ' || c == L'\t' || c == L'\n') {
+			if (c == L' ')
+				x += whitespace;
+			else if (c == L'\t')
+				x += whitespace * 4;
+			else {
+				x = 0.0f;
+				y += line;
+			}
+
+			continue;
+		}
+
+		const sf::Glyph& g = font->getGlyph(c, size, false);
+		sf::FloatRect tex(
+			g.textureRect.left - glyph_padding, g.textureRect.top - glyph_padding,
+			g.textureRect.width + 2 * glyph_padding, g.textureRect.height + 2 * glyph_padding);
+
+		quad(page, transform, colour,
+			x + g.bounds.left - glyph_padding, y + g.bounds.top - glyph_padding,
+			x + g.bounds.left + g.bounds.width + glyph_padding, y + g.bounds.top + g.bounds.height + glyph_padding, tex);
+
+		x += g.advance;
+	}
+}
+
+void render_batch::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+	if (_rects.getVertexCount() > 0)
+		target.draw(_rects, states);
+
+	for (const auto& p : _glyphs) {
+		if (p.second.getVertexCount() == 0)
+			continue;
+
+		states.texture = p.first;
+		target.draw(p.second, states);
+	}
+}
+
+sf::VertexArray& render_batch::_page(const sf::Texture* texture) {
+	for (auto& p : _glyphs) {
+		if (p.first == texture)
+			return p.second;
+	}
+
+	_glyphs.emplace_back(texture, sf::VertexArray(sf::Triangles));
+	return _glyphs.back().second;
+}
@@ -0,0 +1,59 @@
+/*
+ * batch.hpp:
+ * draw many rectangles and texts in a few draw calls, rather than two or three each
+ * every rectangle (fill and outline) goes into one vertex array
+ * every glyph goes into one vertex array per font texture, i.e. per character size, the same quads sf::Text would make
+ * widgets add themselves with batch() and call render_batch::changed() whenever they look different,
+ * so a batch is only rebuilt when something it holds has changed
+ */
+
+#ifndef _BATCH_HPP
+#define _BATCH_HPP
+
+#include <SFML/Graphics.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class render_batch : public sf::Drawable {
+public:
+	render_batch();
+
+	// something drawn has changed since the last rebuild, e.g. a string or a colour
+	static void changed() noexcept {
+		_changes()++;
+	}
+
+	// whether anything changed since this batch was last cleared
+	bool stale() const noexcept {
+		return _built != _changes();
+	}
+
+	// empty the batch to be rebuilt, up to date as of now
+	void clear();
+
+	// a rectangle's fill and outline, as sf::RectangleShape would draw it
+	void add(const sf::RectangleShape& shape);
+
+	// the glyphs of a text, as sf::Text would draw it
+	void add(const sf::Text& text);
+
+	// one draw call for the rectangles and one for each font texture used
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+	static std::size_t& _changes() noexcept {
+		static std::size_t changes = 0;
+		return changes;
+	}
+
+	// the vertices of glyphs on texture, made the first time it is used
+	sf::VertexArray& _page(const sf::Texture* texture);
+
+	sf::VertexArray _rects;
+	std::vector<std::pair<const sf::Texture*, sf::VertexArray>> _glyphs;
+	std::size_t _built;
+};
+
+#endif // !_BATCH_HPP
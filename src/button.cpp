@@ -1,8 +1,10 @@
 /*
  * button.cpp:
- * define storage for button styles
+ * define storage for button styles and the router of mouse events to buttons
  */
 
+#include <algorithm>
+
 #include "button.hpp"
 
 const button_style button_style::default_orange = {
@@ -28,3 +30,61 @@ const button_style button_style::default_grey = {
 	0.0f, // no internal padding
 	1.0f // 1 second fade time
 };
+
+button_router& button_router::get() {
+	static button_router router;
+	return router;
+}
+
+void button_router::place(basic_button* b, const sf::FloatRect& bounds) {
+	_grid.place(b, { bounds.left, bounds.top, bounds.width, bounds.height });
+}
+
+void button_router::remove(basic_button* b) {
+	_grid.remove(b);
+	_over.erase(std::remove(_over.begin(), _over.end(), b), _over.end());
+}
+
+void button_router::_hit(int x, int y) {
+	_hits.clear();
+
+	_grid.near(static_cast<float>(x), static_cast<float>(y), [this, x, y](basic_button* b) {
+		if (b->mouse_intersect(x, y))
+			_hits.push_back(b);
+	});
+}
+
+// only the buttons the mouse left or is over hear of a move
+void button_router::listen(const event::sf_event::MouseMoved& t) {
+	_hit(t.value.mouseMove.x, t.value.mouseMove.y);
+
+	for (auto b : _over) {
+		if (std::find(_hits.begin(), _hits.end(), b) == _hits.end())
+			b->mouse_over(false);
+	}
+
+	for (auto b : _hits)
+		b->mouse_over(true);
+
+	std::swap(_over, _hits);
+}
+
+void button_router::listen(const event::sf_event::MouseButtonPressed& t) {
+	if (t.value.mouseButton.button != sf::Mouse::Button::Left)
+		return;
+
+	_hit(t.value.mouseButton.x, t.value.mouseButton.y);
+
+	for (auto b : _hits)
+		b->mouse_pressed();
+}
+
+void button_router::listen(const event::sf_event::MouseButtonReleased& t) {
+	if (t.value.mouseButton.button != sf::Mouse::Button::Left)
+		return;
+
+	_hit(t.value.mouseButton.x, t.value.mouseButton.y);
+
+	for (auto b : _hits)
+		b->mouse_released();
+}
@@ -10,7 +10,9 @@
 
 #include <unordered_map>
 #include <iostream>
+#include <vector>
 
+#include "hit_grid.hpp"
 #include "event.hpp"
 #include "text.hpp"
 
@@ -39,15 +41,44 @@ struct button_style {
 	static const button_style default_grey;
 };
 
-// the button class
-// which listens to SFML mouse events for state changes
-class basic_button :
-	public sf::Drawable,
+class basic_button;
+
+// the one listener to SFML mouse events for every button
+// finds the buttons under the mouse from a hit_grid of their bounds, once per event,
+// and tells only those buttons, and those the mouse has just left
+class button_router :
 	public event::class_listener<
 		event::sf_event::MouseMoved,
 		event::sf_event::MouseButtonPressed,
 		event::sf_event::MouseButtonReleased> {
 
+public:
+	static button_router& get();
+
+	// where b is, on every change of its bounds
+	void place(basic_button* b, const sf::FloatRect& bounds);
+
+	// b is gone
+	void remove(basic_button* b);
+
+	virtual void listen(const event::sf_event::MouseMoved& t) override;
+	virtual void listen(const event::sf_event::MouseButtonPressed& t) override;
+	virtual void listen(const event::sf_event::MouseButtonReleased& t) override;
+
+private:
+	button_router()=default;
+
+	// the buttons under (x, y), into _hits
+	void _hit(int x, int y);
+
+	util::hit_grid<basic_button*> _grid;
+	std::vector<basic_button*> _over; // under the mouse as of its last move
+	std::vector<basic_button*> _hits;
+};
+
+// the button class
+// which changes state on the mouse events button_router gives it
+class basic_button : public sf::Drawable {
 public:
 	// default to grey style if no parameters are passed
 	// this is necessary because else an array of buttons cannot be implicitly initialized
@@ -60,6 +91,14 @@ public:
 		set_state(button_state::normal);
 	};
 
+	// a button is routed to by its address
+	basic_button(const basic_button&)=delete;
+	basic_button& operator=(const basic_button&)=delete;
+
+	virtual ~basic_button() {
+		button_router::get().remove(this);
+	}
+
 	// change attributes of member text and rect
 	void set_style(button_style style) {
 		_style = style;
@@ -75,6 +114,9 @@ public:
 		// reset any fades
 		_fade_progress = 1.0f;
 		_rect_target_colour = _style.fill_colour.at(button_state::normal);
+
+		button_router::get().place(this, _shape.getGlobalBounds());
+		render_batch::changed();
 	}
 
 	// set button state and modify fill colour
@@ -83,7 +125,7 @@ public:
 		_state = state;
 
 		if (_style.fade_time <= 0.0f) // do not fade
-			_shape.setFillColor(_style.fill_colour.at(_state));
+			_fill(_style.fill_colour.at(_state));
 		else {
 			_rect_target_colour = _style.fill_colour.at(_state);
 			_fade_progress = 0.0f;
@@ -100,6 +142,9 @@ public:
 		_shape.setPosition(bounds.left, bounds.top);
 		_shape.setSize(sf::Vector2f(bounds.width - _style.internal_padding, bounds.height - _style.internal_padding));
 		_text.set_bounds(bounds);
+
+		button_router::get().place(this, _shape.getGlobalBounds());
+		render_batch::changed();
 	}
 
 	// do not ignore click events
@@ -123,18 +168,15 @@ public:
 		std::cout << "basic_button was clicked!" << std::endl;
 	}
 
-	// determine if the mouse is intersecting with this button object
-	// needs the RenderWindow* object to translate mouse coords to window coords
-	bool mouse_intersect(const sf::RenderWindow* win) const {
-
-		// transform mouse space to window space
-		auto mp = win->mapCoordsToPixel(sf::Vector2f(sf::Mouse::getPosition(*win).x, sf::Mouse::getPosition(*win).y));
-
+	// determine if the mouse at (x, y) is intersecting with this button object
+	// the position is taken from the event rather than sf::Mouse so a replayed event (see core::replay) hits the same buttons
+	// window and view coordinates are the same, as core::run keeps the view the size of the window
+	bool mouse_intersect(int x, int y) const {
 		sf::FloatRect mouse_box;
 		mouse_box.width = 1;
 		mouse_box.height = 1;
-		mouse_box.left = mp.x;
-		mouse_box.top = mp.y;
+		mouse_box.left = x;
+		mouse_box.top = y;
 
 		return _shape.getGlobalBounds().intersects(mouse_box);
 	}
@@ -145,6 +187,12 @@ public:
 		target.draw(_text);
 	}
 
+	// add this object's components to a batch, to be drawn with everything else in it
+	void batch(render_batch& b) const {
+		b.add(_shape);
+		_text.batch(b);
+	}
+
 	// fade the button's fill by a delta time i.e. linearly interpolate between active states
 	void fade(float dt) {
 		if (_fade_progress < 1.0f) {
@@ -163,14 +211,19 @@ public:
 			target.g = lerp(_shape.getFillColor().g, _rect_target_colour.g, _fade_progress);
 			target.b = lerp(_shape.getFillColor().b, _rect_target_colour.b, _fade_progress);
 
-			_shape.setFillColor(target);
+			_fill(target);
 		} else {
 
 			// the target colour has been reached so lerping is no longer necessary
-			_shape.setFillColor(_rect_target_colour);
+			_fill(_rect_target_colour);
 		}
 	}
 
+	// whether fade() still has a colour to change
+	bool fading() const {
+		return _fade_progress < 1.0f || _shape.getFillColor() != _rect_target_colour;
+	}
+
 	// fake a click
 	// does not modify rendering of the button
 	// instead use simulate_click_pressed() + simulate_click_released()
@@ -189,53 +242,50 @@ public:
 		on_click();
 	}
 
-	// listen to mouse move event from the event dispatch
-	virtual void listen(const event::sf_event::MouseMoved& t) override {
-		auto intersects = mouse_intersect(t.rw);
-
+	// the mouse moved onto this button, or off it
+	virtual void mouse_over(bool over) {
 		// when intersecting --> hover
 		// otherwise --> normal
-		if (intersects && _state == button_state::normal)
+		if (over && _state == button_state::normal)
 			set_state(button_state::hover);
-		if (!intersects && _state != button_state::normal)
+		if (!over && _state != button_state::normal)
 			set_state(button_state::normal);
 	}
 
-	// listen to mouse pressed event (the instant when the mouse is pressed down) from the event dispatch
-	virtual void listen(const event::sf_event::MouseButtonPressed& t) override {
+	// the left mouse button was pressed (the instant when the mouse is pressed down) on this button
+	virtual void mouse_pressed() {
 		if (!_enabled)
 			return;
 
-		if (t.value.mouseButton.button == sf::Mouse::Button::Left) {
-			auto intersects = mouse_intersect(t.rw);
-
-			// update state but don't call on_click yet
-			// that will be called when mouse button is released
-			if (intersects)
-				set_state(button_state::click);
-		}
+		// update state but don't call on_click yet
+		// that will be called when mouse button is released
+		set_state(button_state::click);
 	}
 
-	// listen to mouse pressed event (the instant when the mouse is released) from the event dispatch
-	virtual void listen(const event::sf_event::MouseButtonReleased& t) override {
+	// the left mouse button was released (the instant when the mouse is released) on this button
+	virtual void mouse_released() {
 		if (!_enabled)
 			return;
 
-		if (t.value.mouseButton.button == sf::Mouse::Button::Left) {
-			auto intersects = mouse_intersect(t.rw);
-
-			// only trigger click if the mouse is still intersecting, meaning:
-			// if a click is pressed down on a button but then the mouse is moved away
-			// while the button is still down, do not trigger a click
-			// this means mis-clicks can be cancelled
-			if (intersects && _state == button_state::click) {
-				on_click();
-				set_state(button_state::hover);
-			}
+		// only trigger click if the mouse is still intersecting, meaning:
+		// if a click is pressed down on a button but then the mouse is moved away
+		// while the button is still down, do not trigger a click
+		// this means mis-clicks can be cancelled
+		if (_state == button_state::click) {
+			on_click();
+			set_state(button_state::hover);
 		}
 	}
 
 private:
+	// change the fill, a batch holding the old one is out of date
+	void _fill(const sf::Color& c) {
+		if (_shape.getFillColor() != c) {
+			_shape.setFillColor(c);
+			render_batch::changed();
+		}
+	}
+
 	// consider using a style ref/ptr to prevent extra copy
 	button_style _style;
 	button_state _state;
@@ -3,106 +3,259 @@
  * dispatch events on update and make calls to runnable object
  */
 
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+
 #include "core.hpp"
 #include "event.hpp"
 
+namespace {
+
+	// queue an SFML driven event with the event manager, delivered by the next event::drain()
+	// these can be handled by any class for whatever reason
+	// when no one is listening to a specific event it is dropped before it is copied (see event::sf_event_table)
+	// returns false once the window is closed
+	bool dispatch(const sf::Event& e, sf::RenderWindow* win) {
+		if (e.type == sf::Event::Closed)
+			return false;
+
+		event::sf_event_table::queue(e, win);
+
+		// it's sub-optimal when a window is resized
+		// but when it happens do not rescale everything
+		if (e.type == sf::Event::Resized && win)
+			win->setView(sf::View(sf::FloatRect(0.0f, 0.0f, static_cast<float>(e.size.width), static_cast<float>(e.size.height))));
+
+		return true;
+	}
+
+	// the recorder of the running run(), flushed by flush_recording()
+	recording::recorder* recording_now = nullptr;
+
+	// std::exit() (the EXIT button, finishing the last level) skips run()'s locals
+	// so the input of its last frame would never reach the file without this
+	void flush_recording() {
+		if (recording_now)
+			recording_now->flush();
+	}
+
+	// how long an idle frame sleeps between looking for input, once other threads send events
+	// waitEvent() can't be woken by them, so this bounds how late a sent event is delivered
+	const sf::Time idle_nap = sf::milliseconds(5);
+
+	// a hitch longer than this is dropped rather than caught up with fixed steps
+	// animations pause through it rather than skip, and a slow machine can't fall ever further behind
+	const float max_lag = 0.25f;
+
+	// the times between frames, as a histogram for quantiles and running sums for the mean and deviation
+	class frame_timer {
+	public:
+		frame_timer(unsigned int fps)
+			: _target(fps ? 1000.0 / fps : 0.0), _count(0), _mean(0.0), _m2(0.0), _worst(0.0), _late(0), _buckets(buckets, 0) {
+		}
+
+		void add(double ms) {
+			// welford's running variance
+			_count++;
+			double delta = ms - _mean;
+			_mean += delta / _count;
+			_m2 += delta * (ms - _mean);
+
+			_worst = std::max(_worst, ms);
+			if (_target > 0.0 && ms > 1.5 * _target)
+				_late++;
+
+			_buckets[std::min(static_cast<std::size_t>(ms / width), buckets - 1)]++;
+		}
+
+		core::frame_jitter jitter() const {
+			return core::frame_jitter {
+				_mean, _count > 1 ? std::sqrt(_m2 / (_count - 1)) : 0.0,
+				_quantile(0.5), _quantile(0.99), _worst, _late
+			};
+		}
+
+	private:
+		// 0.1ms buckets up to 200ms, the last holding everything slower
+		static const std::size_t buckets = 2000;
+		static constexpr double width = 0.1;
+
+		// the upper edge of the bucket holding the q-th quantile
+		double _quantile(double q) const {
+			std::size_t rank = static_cast<std::size_t>(q * _count) + 1, seen = 0;
+
+			for (std::size_t b = 0; b < buckets; b++) {
+				seen += _buckets[b];
+
+				if (seen >= rank)
+					return std::min((b + 1) * width, _worst);
+			}
+
+			return 0.0;
+		}
+
+		double _target;
+		std::size_t _count;
+		double _mean, _m2, _worst;
+		std::size_t _late;
+		std::vector<std::size_t> _buckets;
+	};
+};
+
 namespace core {
-	void run(runnable& r) {
+	run_stats run(runnable& r, const std::string& record, const run_options& options) {
+		std::unique_ptr<recording::recorder> rec;
+		if (!record.empty()) {
+			rec.reset(new recording::recorder(record));
+
+			static bool hooked = (std::atexit(flush_recording) == 0);
+			(void)hooked;
+			recording_now = rec.get();
+		}
+
+		// log what the game does alongside the input, including anything done by setup()
+		auto noted = event::dispatch<recording::note>::connect([&rec](const recording::note& n) {
+			if (rec)
+				rec->note(n);
+		});
+
 		auto win = r.setup();
 
-		sf::Clock clk;
+		// the window size is only known once it exists
+		if (rec)
+			rec->start(win->getSize());
+
+		// sfml paces with either, never both
+		win->setVerticalSyncEnabled(options.vsync);
+		win->setFramerateLimit(options.vsync ? 0 : options.fps);
+
+		sf::Clock clk, total, asleep, paced;
+		std::clock_t cpu = std::clock();
+		run_stats stats = { 0, 0.0, 0.0, 0.0, frame_jitter() };
+		frame_timer timer(options.vsync ? 0 : options.fps);
+
+		// time not yet updated, less than a tick
+		float lag = 0.0f;
+
+		// whether anything happened since the last frame, the first frame is always drawn
+		bool changed = true;
 
 		bool running = true;
 		while (running) {
-
-			// dispatch SFML driven events through the event manager
-			// these can be handled by any class for whatever reason
-			// when no one is listening to a specific event it has minimal performance hit
 			auto e = sf::Event();
-			while (win->pollEvent(e)) {
-				switch (e.type) {
-					case sf::Event::MouseMoved:
-						event::dispatch<event::sf_event::MouseMoved>::post(event::sf_event::MouseMoved(e, win.get()));
-						break;
-					case sf::Event::KeyPressed:
-						event::dispatch<event::sf_event::KeyPressed>::post(event::sf_event::KeyPressed(e, win.get()));
-						break;
-					case sf::Event::KeyReleased:
-						event::dispatch<event::sf_event::KeyReleased>::post(event::sf_event::KeyReleased(e, win.get()));
-						break;
-					case sf::Event::MouseButtonPressed:
-						event::dispatch<event::sf_event::MouseButtonPressed>::post(event::sf_event::MouseButtonPressed(e, win.get()));
-						break;
-					case sf::Event::MouseButtonReleased:
-						event::dispatch<event::sf_event::MouseButtonReleased>::post(event::sf_event::MouseButtonReleased(e, win.get()));
-						break;
-					case sf::Event::MouseWheelMoved:
-						event::dispatch<event::sf_event::MouseWheelMoved>::post(event::sf_event::MouseWheelMoved(e, win.get()));
-						break;
-					case sf::Event::MouseWheelScrolled:
-						event::dispatch<event::sf_event::MouseWheelScrolled>::post(event::sf_event::MouseWheelScrolled(e, win.get()));
-						break;
-					case sf::Event::MouseEntered:
-						event::dispatch<event::sf_event::MouseEntered>::post(event::sf_event::MouseEntered(e, win.get()));
-						break;
-					case sf::Event::MouseLeft:
-						event::dispatch<event::sf_event::MouseLeft>::post(event::sf_event::MouseLeft(e, win.get()));
-						break;
-					case sf::Event::TextEntered:
-						event::dispatch<event::sf_event::TextEntered>::post(event::sf_event::TextEntered(e, win.get()));
-						break;
-					case sf::Event::LostFocus:
-						event::dispatch<event::sf_event::LostFocus>::post(event::sf_event::LostFocus(e, win.get()));
-						break;
-					case sf::Event::GainedFocus:
-						event::dispatch<event::sf_event::GainedFocus>::post(event::sf_event::GainedFocus(e, win.get()));
-						break;
-					case sf::Event::Resized:
-						event::dispatch<event::sf_event::Resized>::post(event::sf_event::Resized(e, win.get()));
-
-						// it's sub-optimal when a window is resized
-						// but when it happens do not rescale everything
-						win->setView(sf::View(sf::FloatRect(0.0f, 0.0f, static_cast<float>(e.size.width), static_cast<float>(e.size.height))));
-						break;
-					case sf::Event::JoystickButtonPressed:
-						event::dispatch<event::sf_event::JoystickButtonPressed>::post(event::sf_event::JoystickButtonPressed(e, win.get()));
-						break;
-					case sf::Event::JoystickButtonReleased:
-						event::dispatch<event::sf_event::JoystickButtonReleased>::post(event::sf_event::JoystickButtonReleased(e, win.get()));
-						break;
-					case sf::Event::JoystickMoved:
-						event::dispatch<event::sf_event::JoystickMoved>::post(event::sf_event::JoystickMoved(e, win.get()));
-						break;
-					case sf::Event::JoystickConnected:
-						event::dispatch<event::sf_event::JoystickConnected>::post(event::sf_event::JoystickConnected(e, win.get()));
-						break;
-					case sf::Event::JoystickDisconnected:
-						event::dispatch<event::sf_event::JoystickDisconnected>::post(event::sf_event::JoystickDisconnected(e, win.get()));
-						break;
-					case sf::Event::TouchBegan:
-						event::dispatch<event::sf_event::TouchBegan>::post(event::sf_event::TouchBegan(e, win.get()));
-						break;
-					case sf::Event::TouchMoved:
-						event::dispatch<event::sf_event::TouchMoved>::post(event::sf_event::TouchMoved(e, win.get()));
-						break;
-					case sf::Event::TouchEnded:
-						event::dispatch<event::sf_event::TouchEnded>::post(event::sf_event::TouchEnded(e, win.get()));
-						break;
-					case sf::Event::SensorChanged:
-						event::dispatch<event::sf_event::SensorChanged>::post(event::sf_event::SensorChanged(e, win.get()));
-						break;
-					case sf::Event::Closed:
-						running = false;
-						break;
-					default:
-						break;
+
+			// the last frame is still right and will stay right until an event arrives
+			// so block for one, rather than spin drawing the same frame
+			// once another thread has sent an event (see event::dispatch::send) nap between polls instead
+			// so what it sends is delivered within idle_nap, rather than with the next input
+			if (options.idle && !changed && !r.animating()) {
+				asleep.restart();
+
+				bool input = false;
+				if (event::inboxes().load(std::memory_order_acquire) == nullptr)
+					input = win->waitEvent(e);
+				else {
+					while (!(input = win->pollEvent(e)) && !event::pending())
+						sf::sleep(idle_nap);
 				}
+
+				if (input) {
+					if (rec)
+						rec->event(e);
+
+					running = dispatch(e, win.get());
+				}
+
+				stats.idle += asleep.getElapsedTime().asSeconds();
+
+				// the time asleep isn't time animated, a fade starting now starts from zero
+				clk.restart();
+				paced.restart();
+			}
+
+			changed = false;
+
+			while (running && win->pollEvent(e)) {
+				if (rec)
+					rec->event(e);
+
+				running = dispatch(e, win.get());
+				changed = true;
 			}
 
-			// draw and recalculate delta time from the clock
+			// deliver this frame's events, and whatever the game queues in response, all at once
+			// consecutive mouse moves (see event::coalesce) reach listeners as the last of them
+			event::drain();
+
+			// update, draw and recalculate delta time from the clock
+			float dt = clk.restart().asSeconds();
+
+			// in fixed ticks, however long the frame took, so a flash or fade moves the same on any machine
+			// each tick is recorded as a frame of its own, which replay() updates the same way
+			if (options.tick > 0) {
+				const float step = 1.0f / options.tick;
+
+				for (lag = std::min(lag + dt, max_lag); lag >= step; lag -= step) {
+					if (rec)
+						rec->frame(step);
+
+					r.update(step);
+				}
+			} else {
+				if (rec)
+					rec->frame(dt);
+
+				r.update(dt);
+			}
+
+			// a frame shorter than a tick updates nothing, its input is written all the same
+			if (rec)
+				rec->flush();
+
 			win->clear(sf::Color::Black);
-			r.update(win.get(), clk.restart().asSeconds());
+			r.draw(*win);
 			win->display();
+
+			// the first frame waited on setup()
+			if (stats.frames++ > 0)
+				timer.add(paced.getElapsedTime().asMicroseconds() / 1000.0);
+
+			paced.restart();
 		}
+
+		stats.jitter = timer.jitter();
+
+		stats.seconds = total.getElapsedTime().asSeconds();
+		stats.cpu = static_cast<double>(std::clock() - cpu) / CLOCKS_PER_SEC;
+
+		noted.disconnect();
+		recording_now = nullptr;
+		return stats;
+	}
+
+	// the same as run() less the window, the clock and drawing
+	std::size_t replay(runnable& r, recording::player& p) {
+		r.prepare(p.size());
+
+		sf::Event e;
+		float dt = 0.0f;
+		std::size_t frames = 0;
+
+		for (auto k = p.next(e, dt); k != recording::player::kind::end; k = p.next(e, dt)) {
+			if (k == recording::player::kind::frame) {
+				event::drain();
+				r.update(dt);
+				frames++;
+			}
+			else if (!dispatch(e, nullptr))
+				return frames;
+		}
+
+		// input after the last frame, recorded just before the game exited
+		event::drain();
+		return frames;
 	}
 };
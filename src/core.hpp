@@ -9,6 +9,7 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 
+#include "recording.hpp"
 #include "util.hpp"
 
 namespace core {
@@ -16,17 +17,67 @@ namespace core {
 	public:
 
 		// override-able window generator, acts as program initializer
+		// implementations should prepare() for the size of the window they make
 		virtual std::unique_ptr<sf::RenderWindow> setup() {
-			return util::make_unique<sf::RenderWindow>(sf::VideoMode::getDesktopMode(), "my app", sf::Style::Default);
+			auto win = util::make_unique<sf::RenderWindow>(sf::VideoMode::getDesktopMode(), "my app", sf::Style::Default);
+			prepare(win->getSize());
+
+			return win;
 		}
 
-		// pure abstract update, draw routine to be called per update
+		// lay everything out for a window of size
+		// replay() calls this instead of setup() as it has no window
+		virtual void prepare(const sf::Vector2u& size) { }
+
+		// pure abstract update routine to be called per frame, before draw()
 		// dt is a calculated delta time i.e. the ms/1000 passed since last update
-		virtual void update(sf::RenderWindow* rw, float dt)=0;
+		virtual void update(float dt)=0;
+
+		// pure abstract draw routine to be called per frame
+		virtual void draw(sf::RenderTarget& target)=0;
+
+		// whether update() would change what is drawn without any new event, e.g. mid animation
+		// while it is false and no events arrive run() sleeps rather than drawing the same frame again
+		virtual bool animating() const { return true; }
+	};
+
+	// how run() paces frames
+	// the defaults draw at most 60 frames a second and update 120 times a second, whatever the frame rate
+	struct run_options {
+		run_options() : idle(true), vsync(false), fps(60), tick(120) { }
+
+		bool idle; // sleep in sf::Window::waitEvent while nothing is animating (see runnable::animating)
+		bool vsync; // wait for the display's refresh, fps is ignored as the two fight each other
+		unsigned int fps; // frames a second at most, 0 for as many as possible
+		unsigned int tick; // runnable::update calls a second with a fixed dt of 1/tick, 0 for one call a frame with the frame's dt
+	};
+
+	// the spread of the times between frames in ms, to check the pacing by
+	// frames after run() slept (see run_options::idle) are timed from when it woke
+	struct frame_jitter {
+		double mean, deviation;
+		double p50, p99, worst;
+		std::size_t late; // frames taking over one and a half times as long as fps asks
+	};
+
+	// what run() spent its time on
+	struct run_stats {
+		std::size_t frames;
+		double seconds; // from the first frame to the window closing
+		double idle; // of those, asleep waiting for an event
+		double cpu; // processor time of the whole process over those seconds
+		frame_jitter jitter;
 	};
 
 	// enter a main loop with calls to a runnable
-	void run(runnable& r);
+	// logging every event and frame to the file record when it isn't empty (see recording.hpp)
+	// throws std::runtime_error when record can't be written
+	run_stats run(runnable& r, const std::string& record="", const run_options& options=run_options());
+
+	// feed a recording back through the event manager and update(), without a window or any frame pacing
+	// events are posted with a null sf::RenderWindow*
+	// returns the number of frames replayed
+	std::size_t replay(runnable& r, recording::player& p);
 }
 
 #endif // _CORE_HPP
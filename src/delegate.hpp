@@ -0,0 +1,140 @@
+/*
+ * delegate.hpp:
+ * a callable like std::function, without the heap for the small callables events are listened to with
+ * a member function bound to an object, or a lambda capturing no more than two pointers, is kept inline
+ * and called through a single trampoline, anything larger is copied to the heap as std::function would
+ */
+
+#ifndef _DELEGATE_HPP
+#define _DELEGATE_HPP
+
+#include <type_traits>
+#include <cstring>
+#include <utility>
+#include <new>
+
+namespace util {
+
+	template <typename Signature>
+	class delegate;
+
+	template <typename R, typename ...A>
+	class delegate<R(A...)> {
+	public:
+		delegate() noexcept
+			: _call(nullptr), _manage(nullptr) {
+		}
+
+		// wrap any callable f, inline when it is small and trivially copyable
+		template <typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, delegate>::value>::type>
+		delegate(F&& f)
+			: _manage(nullptr) {
+			typedef typename std::decay<F>::type callable;
+			_store<callable>(std::forward<F>(f), std::integral_constant<bool, fits<callable>()>());
+		}
+
+		// call method M on object, e.g. delegate<void(int)>::bind<foo, &foo::bar>(&f)
+		template <typename C, R (C::*M)(A...)>
+		static delegate bind(C* object) {
+			delegate d;
+			std::memcpy(&d._storage, &object, sizeof(object));
+			d._call = [](void* s, A... a) -> R {
+				C* o;
+				std::memcpy(&o, s, sizeof(o));
+				return (o->*M)(std::forward<A>(a)...);
+			};
+
+			return d;
+		}
+
+		delegate(const delegate& d)
+			: _call(d._call), _manage(d._manage) {
+			if (_manage)
+				_manage(&_storage, &d._storage, op::clone);
+			else
+				_storage = d._storage;
+		}
+
+		delegate(delegate&& d) noexcept
+			: _storage(d._storage), _call(d._call), _manage(d._manage) {
+			d._call = nullptr;
+			d._manage = nullptr;
+		}
+
+		delegate& operator=(delegate d) noexcept {
+			std::swap(_storage, d._storage);
+			std::swap(_call, d._call);
+			std::swap(_manage, d._manage);
+
+			return *this;
+		}
+
+		~delegate() {
+			if (_manage)
+				_manage(&_storage, nullptr, op::destroy);
+		}
+
+		R operator()(A... a) const {
+			return _call(&_storage, std::forward<A>(a)...);
+		}
+
+		explicit operator bool() const noexcept {
+			return _call != nullptr;
+		}
+
+	private:
+		// room for an object and a pointer, or a lambda capturing two references
+		typedef typename std::aligned_storage<2 * sizeof(void*), alignof(void*)>::type storage;
+
+		enum class op {
+			clone,
+			destroy
+		};
+
+		template <typename F>
+		static constexpr bool fits() {
+			return sizeof(F) <= sizeof(storage) && alignof(F) <= alignof(storage) && std::is_trivially_copyable<F>::value;
+		}
+
+		// inline, copied bytewise and never destroyed
+		template <typename F>
+		void _store(F f, std::true_type) {
+			new (&_storage) F(std::move(f));
+			_call = [](void* s, A... a) -> R {
+				return (*static_cast<F*>(s))(std::forward<A>(a)...);
+			};
+		}
+
+		// on the heap, the storage holds a pointer to it
+		template <typename F>
+		void _store(F f, std::false_type) {
+			F* p = new F(std::move(f));
+			std::memcpy(&_storage, &p, sizeof(p));
+
+			_call = [](void* s, A... a) -> R {
+				F* f;
+				std::memcpy(&f, s, sizeof(f));
+				return (*f)(std::forward<A>(a)...);
+			};
+
+			_manage = [](storage* to, const storage* from, op o) {
+				F* f;
+
+				if (o == op::clone) {
+					std::memcpy(&f, from, sizeof(f));
+					f = new F(*f);
+					std::memcpy(to, &f, sizeof(f));
+				} else {
+					std::memcpy(&f, to, sizeof(f));
+					delete f;
+				}
+			};
+		}
+
+		mutable storage _storage;
+		R (*_call)(void*, A...);
+		void (*_manage)(storage*, const storage*, op); // nullptr when inline
+	};
+};
+
+#endif // !_DELEGATE_HPP
@@ -0,0 +1,282 @@
+/*
+ * dispatch.hpp
+ * an interface for posting and listening to events across classes, of any type and without SFML
+ * the event system is single threaded, apart from dispatch<T>::send() which any thread may call
+ * a naive culmination of the ideas in many existing event libraries, namely:
+ * events - https://github.com/LB--/events
+ * Events - https://github.com/Submanifold/Events
+ * events - https://github.com/MCGallaspy/events
+ */
+
+#ifndef _DISPATCH_HPP
+#define _DISPATCH_HPP
+
+#include <type_traits>
+#include <atomic>
+#include <vector>
+
+#include "delegate.hpp"
+#include "slot_map.hpp"
+#include "mpsc.hpp"
+#include "ring.hpp"
+#include "trace.hpp"
+
+namespace event
+{
+	// a pure abstract class that listens to events of type T
+	// these are passed to void listen(const T&);
+	template <typename ...T>
+	class class_listener;
+
+	// a lambda/std::bind/function ptr to listens to an event
+	// small lambdas are kept without allocating, see delegate.hpp
+	template <typename T>
+	using lambda_listener = util::delegate<void(const T& t)>;
+
+	// what a dispatch keeps per connection: a class_listener or, when that is null, a lambda_listener
+	// a class_listener is called straight through its vtable, rather than through a lambda
+	template <typename T>
+	struct listener {
+		class_listener<T>* object;
+		lambda_listener<T> function;
+	};
+
+	// (static) class for posting events and
+	// connecting a listener to a type dispatch
+	template <typename T>
+	class dispatch;
+
+	// whether only the latest of the queued events of T matters, e.g. a mouse position or a snapshot of some text
+	// specialise as std::true_type to have dispatch<T>::queue() merge events of T queued one straight after another
+	template <typename T>
+	struct coalesce : std::false_type { };
+
+	// the order every queued event is delivered in, one entry per event, across every type
+	// each entry delivers the front of its own type's queue
+	inline std::vector<void (*)()>& queued() {
+		static std::vector<void (*)()> order;
+		return order;
+	}
+
+	// where the events other threads send (see dispatch<T>::send) wait for drain()
+	// one per type, linked in the first time the type is sent and never unlinked
+	struct inbox {
+		inbox* next;
+		void (*collect)(); // queue what has been sent so far
+		bool (*pending)(); // whether anything has been sent that collect() hasn't queued
+	};
+
+	// events of one type queued from an inbox by one drain(), the rest wait for the next
+	const std::size_t max_collect = 65536;
+
+	inline std::atomic<inbox*>& inboxes() {
+		static std::atomic<inbox*> head(nullptr);
+		return head;
+	}
+
+	// whether another thread has sent anything a drain() is yet to pick up
+	// cheap enough to ask between naps, it only reads the head of each linked inbox
+	inline bool pending() {
+		for (inbox* i = inboxes().load(std::memory_order_acquire); i != nullptr; i = i->next) {
+			if (i->pending())
+				return true;
+		}
+
+		return false;
+	}
+
+	// post everything queued since the last drain, in the order queued
+	// after queueing what other threads have sent, in the order each thread sent it
+	// events queued by listeners while draining are delivered by the same drain
+	// a drain() from a listener does nothing, the drain already running delivers everything
+	inline void drain() {
+		static bool draining = false;
+		if (draining)
+			return;
+
+		draining = true;
+		auto& order = queued();
+
+#if defined(CALCULATOR_EVENT_TRACE)
+		trace::span s(trace::span::kind::drain, nullptr);
+#endif
+
+		for (inbox* i = inboxes().load(std::memory_order_acquire); i != nullptr; i = i->next)
+			i->collect();
+
+		// index rather than iterator, listeners append to order
+		for (std::size_t i = 0; i < order.size(); i++)
+			order[i]();
+
+		order.clear();
+		draining = false;
+	}
+
+	// a connection between dispatch and listener
+	// a connection can break itself, meaning ignore future event dispatches
+	template <typename T>
+	class connection {
+	public:
+		typedef typename util::slot_map<listener<T>>::handle handle;
+
+		connection(handle h)
+			: _handle(h) {
+		}
+
+		handle get_handle() const noexcept {
+			return _handle;
+		}
+
+		void disconnect() {
+			dispatch<T>::disconnect(*this);
+		}
+
+		virtual ~connection()=default;
+
+	private:
+		handle _handle;
+	};
+
+	template <typename T>
+	class dispatch {
+	public:
+		dispatch()=delete;
+
+		// push a lambda_listener onto the list of listeners, so that it
+		// receives events from any post on dispatch of T type
+		// also return the connection, so it can be broken
+		static connection<T> connect(lambda_listener<T> thing) {
+			return connection<T>(_listeners.insert(listener<T> { nullptr, std::move(thing) }));
+		}
+
+		// connect for class_listener, kept as the object itself
+		// the class_listener disconnects in its destructor so the pointer never dangles
+		static connection<T> connect(class_listener<T>* thing) {
+			return connection<T>(_listeners.insert(listener<T> { thing, lambda_listener<T>() }));
+		}
+
+		// disconnect an event_pair, that is: a listener from this dispatch
+		// breaking a connection twice does nothing
+		static void disconnect(const connection<T>& con) {
+			_listeners.erase(con.get_handle());
+		}
+
+		// whether anything is connected, so a caller can skip making an event no one would hear
+		static bool listened() noexcept {
+			return _listeners.size() > 0;
+		}
+
+		// hold t back until the next drain(), rather than posting it straight away
+		// a coalescing type (see coalesce) replaces its event queued last, but only when nothing was queued since
+		// so a move, press, move, release stays in that order rather than delivering the second move first
+		// an empty _queue means the last entry of T in queued() has already been delivered by this drain
+		static void queue(const T& t) {
+			auto& order = queued();
+
+			if (coalesce<T>::value && !_queue.empty() && order.back() == &_deliver) {
+				_queue.replace_back(t);
+				return;
+			}
+
+			_queue.push_back(t);
+			order.push_back(&_deliver);
+		}
+
+		// queue t from any thread, e.g. a background solver handing its result to the renderer
+		// the drain() on the main thread picks it up, neither side ever waits on the other
+		static void send(const T& t) {
+			_sent.push(t);
+
+			// link this type's inbox in the first time, a drain() that misses it finds it next time
+			if (!_linked.exchange(true, std::memory_order_acq_rel)) {
+				auto& head = inboxes();
+				_inbox.next = head.load(std::memory_order_relaxed);
+
+				while (!head.compare_exchange_weak(_inbox.next, &_inbox, std::memory_order_release, std::memory_order_relaxed));
+			}
+		}
+
+		// send out data to all connected listeners
+		// listeners are kept contiguous (see slot_map.hpp) as posts far outnumber connections
+		// a listener connected during a post only hears the next, one disconnected is skipped straight away
+		// either way a delivery is one indirect call
+		static void post(const T& t) {
+#if defined(CALCULATOR_EVENT_TRACE)
+			trace::span s(trace::span::kind::post, &trace::of<T>());
+#endif
+
+			_listeners.for_each([&t](const listener<T>& l) {
+#if defined(CALCULATOR_EVENT_TRACE)
+				trace::span s(trace::span::kind::listener, &trace::of<T>(), l.object ? &typeid(*l.object) : nullptr);
+#endif
+
+				if (l.object)
+					l.object->listen(t);
+				else
+					l.function(t);
+			});
+		}
+
+	private:
+		// post the oldest queued event, taken off the queue first as listeners may queue more
+		static void _deliver() {
+			T t(_queue.front());
+			_queue.pop_front();
+
+			post(t);
+		}
+
+		// move what other threads have sent into the queue
+		// at most max_collect a drain, so threads sending faster than a frame delivers can't stall it
+		static void _collect() {
+			for (std::size_t n = 0; n < max_collect && _sent.pop([](const T& t) { queue(t); }); n++);
+		}
+
+		static bool _pending() {
+			return !_sent.empty();
+		}
+
+		static util::slot_map<listener<T>> _listeners;
+		static util::ring<T> _queue;
+
+		static util::mpsc_queue<T> _sent;
+		static std::atomic<bool> _linked;
+		static inbox _inbox;
+	};
+
+	// little trick that allows separate data for dispatch of each type
+	template <typename T> util::slot_map<listener<T>> dispatch<T>::_listeners;
+	template <typename T> util::ring<T> dispatch<T>::_queue;
+	template <typename T> util::mpsc_queue<T> dispatch<T>::_sent;
+	template <typename T> std::atomic<bool> dispatch<T>::_linked(false);
+	template <typename T> inbox dispatch<T>::_inbox = { nullptr, &dispatch<T>::_collect, &dispatch<T>::_pending };
+
+	// create overloads of on_event() for each type passed to class_listener
+	// idea from MCGallaspy's events (recursive template inheritance for type overloading)
+	template <>
+	class class_listener<> { };
+
+	template <typename A, typename ...B>
+	class class_listener<A, B...> : public class_listener<A>, public class_listener<B...> { };
+
+	template <typename T>
+	class class_listener<T> {
+	public:
+
+		// this will actually establish a connection for each template parameter
+		explicit class_listener()
+			: _connection(dispatch<T>::connect(this)) {
+		};
+
+		virtual ~class_listener() {
+			_connection.disconnect();
+		};
+
+		virtual void listen(const T& t)=0;
+
+	private:
+		connection<T> _connection;
+	};
+};
+
+#endif // !_DISPATCH_HPP
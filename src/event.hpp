@@ -1,11 +1,6 @@
 /*
  * event.hpp
- * an interface for posting and listening to events across classes
- * the event system is single threaded but could easily be parallelised
- * a naive culmination of the ideas in many existing event libraries, namely:
- * events - https://github.com/LB--/events
- * Events - https://github.com/Submanifold/Events
- * events - https://github.com/MCGallaspy/events
+ * the event system of dispatch.hpp and the SFML events posted through it by core::run
  */
 
 #ifndef _EVENT_HPP
@@ -14,22 +9,13 @@
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 
-#include <unordered_map>
 #include <iostream>
-#include <functional>
 #include <vector>
 
+#include "dispatch.hpp"
+
 namespace event
 {
-	// a pure abstract class that listens to events of type T
-	// these are passed to void listen(const T&);
-	template <typename ...T>
-	class class_listener;
-
-	// a lambda/std::bind/function ptr to listens to an event
-	template <typename T>
-	using lambda_listener = std::function<void(const T& t)>;
-
 	// a way of separating the union of sf::Events into separate types
 	// provides a way of listening to sf events
 	// unfortunately this creates a messy interface
@@ -44,116 +30,6 @@ namespace event
 		sf::RenderWindow* rw;
 	};
 
-	// (static) class for posting events and
-	// connecting a listener to a type dispatch
-	template <typename T>
-	class dispatch;
-
-	// a connection between dispatch and listener
-	// a connection can break itself, meaning ignore future event dispatches
-	template <typename T>
-	class connection {
-	public:
-		connection(std::size_t id)
-			: _id(id) {
-		}
-
-		constexpr std::size_t get_id() const noexcept {
-			return _id;
-		}
-
-		void disconnect() {
-			dispatch<T>::disconnect(*this);
-		}
-
-		virtual ~connection()=default;
-
-	private:
-		std::size_t _id;
-	};
-
-	template <typename T>
-	class dispatch {
-	public:
-		dispatch()=delete;
-
-		// push a lambda_listener onto the list of listeners, so that it
-		// receives events from any post on dispatch of T type
-		// also return the id of this connection, so connections can break
-		static constexpr connection<T> connect(lambda_listener<T> thing) {
-			_listeners[_id] = thing;
-
-			auto ret_val = connection<T>(_id);
-
-			_id++;
-
-			return ret_val;
-		}
-
-		// connect for class_listener, really the same as for a lambda_listener
-		// except have to get an std::mem_fun to be called from within a lambda
-		// need to consider both the performance of this and potential for dangling pointer
-		static connection<T> connect(class_listener<T>* thing) {
-			return connect([thing](const T& t) -> void {
-				std::mem_fun(&class_listener<T>::listen)(thing, t);
-			});
-		}
-
-		// disconnect an event_pair, that is: a listener from this dispatch
-		static void disconnect(const connection<T>& con) {
-			for (auto it = _listeners.begin(); it != _listeners.end();) {
-				if (it->first == con.get_id())
-					it = _listeners.erase(it);
-				else
-					it++;
-			}
-
-		}
-
-		// send out data to all connected listeners
-		static void post(const T& t) {
-			for (const auto& x : _listeners) {
-				x.second(t);
-			}
-		}
-
-	private:
-		static std::size_t _id;
-		static std::unordered_map<std::size_t, lambda_listener<T>> _listeners;
-	};
-
-	// little trick that allows separate data for dispatch of each type
-	template <typename T> std::size_t dispatch<T>::_id;
-	template <typename T> std::unordered_map<std::size_t, lambda_listener<T>> dispatch<T>::_listeners;
-
-	// create overloads of on_event() for each type passed to class_listener
-	// idea from MCGallaspy's events (recursive template inheritance for type overloading)
-	template <>
-	class class_listener<> { };
-
-	template <typename A, typename ...B>
-	class class_listener<A, B...> : public class_listener<A>, public class_listener<B...> { };
-
-	template <typename T>
-	class class_listener<T> {
-	public:
-
-		// this will actually establish a connection for each template parameter
-		// but all these connections have the same id, which doesn't really matter
-		explicit class_listener()
-			: _connection(dispatch<T>::connect(this)) {
-		};
-
-		virtual ~class_listener() {
-			_connection.disconnect();
-		};
-
-		virtual void listen(const T& t)=0;
-
-	private:
-		connection<T> _connection;
-	};
-
 	// to create a nicer interface around sf_typed_event
 	namespace sf_event {
 		using Closed=sf_typed_event<sf::Event::EventType::Closed>;
@@ -180,6 +56,56 @@ namespace event
         using TouchEnded=sf_typed_event<sf::Event::EventType::TouchEnded>;
         using SensorChanged=sf_typed_event<sf::Event::EventType::SensorChanged>;
 	};
+
+	// only the latest mouse position matters
+	template <> struct coalesce<sf_event::MouseMoved> : std::true_type { };
+
+	// queue an sf::Event as its sf_typed_event, through a table with an entry per sf::Event::EventType
+	// the table is generated at compile time for every type up to sf::Event::Count, so new types need no code here
+	// an entry checks for listeners before copying the event, so the types no one listens to
+	// (joysticks, sensors and touches on most machines) cost an indirect call and nothing else
+	class sf_event_table {
+	public:
+		sf_event_table()=delete;
+
+		static void queue(const sf::Event& e, sf::RenderWindow* rw) {
+			if (e.type >= 0 && e.type < sf::Event::Count)
+				_entries()[e.type](e, rw);
+		}
+
+	private:
+		typedef void (*entry)(const sf::Event&, sf::RenderWindow*);
+
+		template <int E>
+		static void _queue(const sf::Event& e, sf::RenderWindow* rw) {
+			typedef sf_typed_event<static_cast<sf::Event::EventType>(E)> typed;
+
+			if (dispatch<typed>::listened())
+				dispatch<typed>::queue(typed(e, rw));
+		}
+
+		// the integers 0 to N - 1 as a pack, std::make_integer_sequence being C++14
+		template <int ...E>
+		struct indices { };
+
+		template <int N, int ...E>
+		struct make_indices : make_indices<N - 1, N - 1, E...> { };
+
+		template <int ...E>
+		struct make_indices<0, E...> {
+			typedef indices<E...> type;
+		};
+
+		template <int ...E>
+		static const entry* _table(indices<E...>) {
+			static const entry table[] = { &_queue<E>... };
+			return table;
+		}
+
+		static const entry* _entries() {
+			return _table(typename make_indices<sf::Event::Count>::type());
+		}
+	};
 };
 
 #endif // _EVENTS_HPP
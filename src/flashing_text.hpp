@@ -98,6 +98,11 @@ public:
 	// get the current flash mode state enumeration
 	flash_mode_t get_flash_mode() const noexcept { return _flash_mode; };
 
+	// whether update() will still change the text, i.e. it is mid flash or yet to be shown after one
+	bool flashing() const noexcept {
+		return _flash_cycle != 0 || !_flash_visible;
+	}
+
 	// calculate whether the text should be visible or not based on the current time
 	// and it's flash_mode as set by set_flash_mode()
 	void update(float dt) {
@@ -136,13 +141,27 @@ public:
 			target.draw(this->_text);
 	}
 
+	// add the text to a batch when it is visible, as draw() would draw it
+	virtual void batch(render_batch& b) const override {
+		if (_flash_visible || _alt_text != nullptr)
+			b.add(this->_text);
+	}
+
 private:
 
 	// private member to change visibility, which depends on whether an alt_string has been set
 	// if it has change the primary string to that, otherwise disable primary
+	// only a string that differs is set, as every set_string() rebuilds the batch
 	void _set_visible(bool to) {
-		if (_alt_text != nullptr)
-			set_string((to)? _primary_text : *_alt_text);
+		if (_alt_text != nullptr) {
+			const std::string& shown = (to)? _primary_text : *_alt_text;
+
+			if (get_string() != shown)
+				set_string(shown);
+		}
+
+		if (_flash_visible != to)
+			render_batch::changed();
 
 		_flash_visible = to;
 	}
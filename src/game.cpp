@@ -0,0 +1,238 @@
+/*
+ * game.cpp:
+ * implements the rules and levels in game.hpp
+ */
+
+#include "game.hpp"
+
+#include <algorithm>
+
+namespace {
+
+	typedef numeric::opcode::kind kind;
+
+	// the default_operation classes of operation.hpp as opcodes, so the levels read the same as they always have
+	numeric::opcode add(int n) { return { kind::add, n }; }
+	numeric::opcode sub(int n) { return { kind::sub, n }; }
+	numeric::opcode mul(int n) { return { kind::mul, n }; }
+	numeric::opcode divi(int n) { return { kind::divi, n }; }
+	numeric::opcode cat(int n) { return { kind::cat, n }; }
+	numeric::opcode del() { return { kind::del, 0 }; }
+	numeric::opcode sign_invert() { return { kind::sign_invert, 0 }; }
+	numeric::opcode power(int n) { return { kind::power, n }; }
+
+	// in no level yet, but the levels calculator_levelgen writes may use them
+	// inline so that being unused isn't a warning
+	inline numeric::opcode mod(int n) { return { kind::mod, n }; }
+	inline numeric::opcode sign_posative() { return { kind::sign_posative, 0 }; }
+
+	// a numeric level: starting number, moves allowed, target number, buttons
+	game::level numeric_level(int primary, int moves, int target, const std::vector<numeric::opcode>& operations) {
+		return game::level { primary, moves, target, operations, {} };
+	}
+
+	// a tutorial level: pairs of text and the button that moves on from it
+	game::level tutorial_level(const std::vector<std::pair<std::string, std::string>>& text) {
+		return game::level { -1, -1, -1, {}, text };
+	}
+};
+
+namespace game {
+
+	// press the operation and decide whether that won or lost the level
+	verdict press(state& s, numeric::opcode op) {
+		int result;
+
+		if (!op.apply(s.primary, result))
+			return verdict::err;
+
+		s.primary = result;
+		s.moves--;
+
+		// reaching the target with the last move is still a win
+		if (s.primary == s.target)
+			return verdict::win;
+
+		if (s.moves <= 0)
+			return verdict::lose;
+
+		return verdict::playing;
+	}
+
+	// definition of all levels
+	// a function local static, as the level manager builds its own list from this during static initialisation
+	const std::vector<level>& levels() {
+		static const std::vector<level> ret ({
+			tutorial_level({
+				{ "below is a grid of buttons, click 'next'", "next" },
+				{ "once you enter the game those will look different", "next" },
+				{ "for example it might say +1 which means add one", "next" },
+				{ "that will add one to the big number", "next" },
+				{ "that number will be where this text is", "next" },
+				{ "above that there will be four pieces of text..", "next" },
+				{ "'level' is how far through the game you are", "next" },
+				{ "'moves' is how many moves you can do before you lose", "next" },
+				{ "'target' is what number you need to try get to", "next" },
+				{ "once you finish a level press the orange NEXT", "next" },
+				{ "if you mess up press to orange AC to restart", "next" },
+				{ "hopefully that helps!", "got it" }
+			}),
+
+			tutorial_level({
+				{ "", "click me" },
+				{ "hello", "hi" },
+				{ "I'm a calculator", "okay" },
+				{ "and I need your help", "okay" },
+				{ "are you up for it?", "sure" },
+				{ "great! I'll give you a starting number", "okay" },
+				{ "and you need to reach the target number", "next" },
+				{ "the target number will be in the top right", "next" },
+				{ "to get to it you need to press buttons", "next" },
+				{ "if the button said '+1' it would add one", "next" },
+				{ "you also have a limited number of moves to reach the target", "next" },
+				{ "if you mess up press the orange AC to reset", "next" },
+				{ "once you finish a level click the orange NEXT", "next" },
+				{ "if you want to change level click MODE", "next" },
+				{ "and for more help click HELP", "next" },
+				{ "oh here's a problem now...", "" }
+			}),
+
+			numeric_level(0, 3, 3, { add(1) }),
+
+			tutorial_level({
+				{ "looks like you're already a master", "thanks" },
+				{ "see if you can do these...", "" }
+			}),
+
+			// starting number, moves allowed, target number, ....
+			numeric_level(2, 2, 5, { add(1), add(2) }),
+			numeric_level(5, 3, 21, { add(7), add(2) }),
+			numeric_level(10, 5, 2, { sub(7), add(2) }),
+			numeric_level(-3, 3, -4, { sub(2), add(3) }),
+			numeric_level(0, 3, 8, { mul(3), add(2) }),
+			numeric_level(3, 4, -16, { mul(-2), add(2) }),
+			numeric_level(4, 3, 126, { mul(6), sub(3) }),
+			numeric_level(7, 4, 56, { mul(-4), add(7) }),
+			numeric_level(100, 3, 5, { divi(5), add(5) }),
+			numeric_level(52, 3, 12, { divi(2), sub(2) }),
+			numeric_level(-3, 4, 190, { mul(5), add(10), add(3) }),
+			numeric_level(2, 3, 256, { power(2) }),
+			numeric_level(0, 3, 9, { power(2), sub(1), sub(2) }),
+
+			tutorial_level({
+				{ "you seem to know your arithmetic pretty well", "thanks" },
+				{ "but there's more to a calculator than just that", "like?" },
+				{ "a new button has been added... good luck", "" }
+			}),
+
+			numeric_level(2, 3, 2112, { cat(1), cat(2) }),
+			numeric_level(8, 4, 888, { cat(2), add(6) }),
+			numeric_level(0, 4, 42, { cat(1), mul(2) }),
+			numeric_level(0, 10, 1011010, { cat(0), add(1) }),
+			numeric_level(25, 4, 111, { cat(5), divi(5) }),
+			numeric_level(3, 4, -5, { cat(2), add(4), divi(-4) }),
+			numeric_level(3, 5, 8, { cat(2), divi(-4), sub(5) }),
+			numeric_level(0, 3, 144, { power(2), sub(1), cat(2) }),
+
+			tutorial_level({
+				{ "that button adds number, this new button deletes them", "" }
+			}),
+
+			numeric_level(111, 2, 1, { del() }),
+			numeric_level(123, 3, 2, { del(), mul(2) }),
+			numeric_level(-25, 3, -9, { del(), sub(6) }),
+			numeric_level(0, 6, -5, { del(), cat(2), sub(6) }),
+
+			tutorial_level({
+				{ "one more button has been added, good luck!", "" }
+			}),
+
+			numeric_level(-5, 1, 5, { sign_invert() }),
+			numeric_level(0, 3, -6, { sign_invert(), add(4), add(2) }),
+			numeric_level(0, 4, -13, { sign_invert(), add(3), sub(7) }),
+			numeric_level(0, 4, 60, { sign_invert(), add(5), sub(10), mul(4) }),
+			numeric_level(44, 5, 52, { sign_invert(), add(9), divi(2), mul(4) }),
+			numeric_level(9, 5, 10, { sign_invert(), add(5), mul(5) }),
+
+			tutorial_level({
+				{ "there are only a few questions left", "wow" },
+				{ "you could actually win this thing", "phew" },
+				{ "good luck...", "" }
+			}),
+
+			numeric_level(14, 5, 12, { sign_invert(), cat(6), add(5), divi(8) }),
+			numeric_level(55, 4, 13, { sign_invert(), del(), add(9) }),
+			numeric_level(0, 5, 245, { sign_invert(), cat(5), sub(3), mul(4) }),
+			numeric_level(39, 4, 12, { sign_invert(), mul(-3), divi(3), add(9) }),
+			numeric_level(111, 6, 126, { sign_invert(), del(), mul(3), sub(9) }),
+
+			tutorial_level({
+				{ "thanks to you all the questions have been solved", "yay!" },
+				{ "you're pretty great!", "thanks" },
+				{ "well, I have to go... bye!", "cya" }
+			})
+		});
+
+		return ret;
+	}
+
+	session::session() : _selected(0), _max(0), _playing(0), _state(levels()[0].start()), _last(verdict::playing), _tutorial(0) {
+
+	}
+
+	void session::go(std::size_t index) {
+		_selected = index;
+		unlock(index);
+	}
+
+	bool session::next() {
+		if (_selected + 1 >= levels().size())
+			return false;
+
+		go(_selected + 1);
+		return true;
+	}
+
+	// ensure no underflows
+	void session::previous() {
+		if (_selected > 0)
+			_selected--;
+	}
+
+	void session::unlock(std::size_t index) {
+		_max = std::max(_max, std::min(index, levels().size() - 1));
+	}
+
+	void session::start() {
+		_playing = _selected;
+		_state = levels()[_playing].start();
+		_last = verdict::playing;
+		_tutorial = 0;
+	}
+
+	verdict session::press(numeric::opcode op) {
+		if (_last != verdict::playing)
+			return _last;
+
+		return _last = game::press(_state, op);
+	}
+
+	verdict session::press(std::size_t button) {
+		return press(current().operations[button]);
+	}
+
+	bool session::advance() {
+		if (_tutorial + 1 >= current().tutorial.size())
+			return false;
+
+		_tutorial++;
+		return true;
+	}
+
+	std::size_t session::selected() const noexcept { return _selected; }
+	std::size_t session::max() const noexcept { return _max; }
+	const level& session::current() const { return levels()[_playing]; }
+	const state& session::numbers() const noexcept { return _state; }
+	verdict session::last() const noexcept { return _last; }
+	std::size_t session::tutorial_index() const noexcept { return _tutorial; }
+};
@@ -0,0 +1,106 @@
+/*
+ * game.hpp:
+ * the rules of the game and its levels without any rendering, events or SFML
+ * numeric_operation::call in operation.hpp and the level manager are built on this,
+ * so the headless tools can play levels exactly as the game would
+ */
+
+#ifndef _GAME_HPP
+#define _GAME_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "numeric.hpp"
+
+namespace game {
+
+	// what a press left the level in
+	enum class verdict {
+		playing, // moves are left and the target hasn't been reached
+		win, // the press reached the target
+		lose, // the press used the last move without reaching the target
+		err // the press failed e.g. 5/2, the game shows ERR!
+	};
+
+	// the numbers shown while a numeric level is played
+	struct state {
+		int primary, moves, target;
+	};
+
+	// press an operation on s, the same as clicking its button in the game
+	// the primary becomes the result and a move is used, unless the press fails
+	// in which case s is left untouched and err is returned
+	verdict press(state& s, numeric::opcode op);
+
+	// a level of the game, either numeric or a tutorial
+	struct level {
+		int primary, moves, target; // -1 for a tutorial
+		std::vector<numeric::opcode> operations;
+
+		// the pairs of text and button string shown one after another, empty for a numeric level
+		std::vector<std::pair<std::string, std::string>> tutorial;
+
+		bool is_tutorial() const { return !tutorial.empty(); }
+
+		// the numbers at the start of a numeric level
+		state start() const { return state { primary, moves, target }; }
+	};
+
+	// every level in the order they are played, level 0 is the instructions screen
+	const std::vector<level>& levels();
+
+	// one player's way through levels(): which level is selected, which is being played and how far
+	// owns everything the game would otherwise keep in statics, so many can be played at once
+	// e.g. one per thread of a validation service, a session is not itself thread safe
+	class session {
+	public:
+
+		// on the instructions screen (level 0), which is not yet started
+		session();
+
+		// select a level without starting it, unlocking it if need be
+		void go(std::size_t index);
+
+		// select the next/previous level without starting it
+		// next() returns false (selecting nothing) when the last level was selected
+		bool next();
+		void previous();
+
+		// allow go() up to index without having played there
+		void unlock(std::size_t index);
+
+		// start the selected level from scratch
+		void start();
+
+		// press an operation on the level being played, see game::press()
+		// a level that was won, lost or ERR! ignores further presses, as the game disables its buttons
+		verdict press(numeric::opcode op);
+
+		// press the button-th operation of the level being played
+		// button must be less than current().operations.size()
+		verdict press(std::size_t button);
+
+		// move a tutorial on to its next text
+		// returns false, staying put, when already on the last
+		bool advance();
+
+		std::size_t selected() const noexcept;
+		std::size_t max() const noexcept; // the highest level that may be selected
+
+		// the level last started and how far through it the player is
+		const level& current() const;
+		const state& numbers() const noexcept;
+		verdict last() const noexcept; // the verdict of the last press, playing once started
+		std::size_t tutorial_index() const noexcept;
+
+	private:
+		std::size_t _selected, _max, _playing;
+		state _state;
+		verdict _last;
+		std::size_t _tutorial;
+	};
+};
+
+#endif // !_GAME_HPP
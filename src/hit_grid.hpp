@@ -0,0 +1,108 @@
+/*
+ * hit_grid.hpp:
+ * finds what lies under a point without testing everything, for routing the mouse to widgets
+ * the space the items cover is cut into a fixed grid of cells, each listing the items overlapping it,
+ * so a lookup tests only the few items of one cell
+ * items are placed rarely (on layout) and looked up often (every mouse event), so every placement rebuilds the cells
+ */
+
+#ifndef _HIT_GRID_HPP
+#define _HIT_GRID_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+	template <typename T>
+	class hit_grid {
+	public:
+		struct rect {
+			float left, top, width, height;
+		};
+
+		hit_grid() : _right(0.0f), _bottom(0.0f) { }
+
+		// put t at r, moving it if it was already placed
+		void place(const T& t, const rect& r) {
+			auto it = _find(t);
+
+			if (it != _items.end())
+				it->second = r;
+			else
+				_items.emplace_back(t, r);
+
+			_rebuild();
+		}
+
+		// take t out, does nothing if it was never placed
+		void remove(const T& t) {
+			auto it = _find(t);
+			if (it == _items.end())
+				return;
+
+			_items.erase(it);
+			_rebuild();
+		}
+
+		// call f on every item whose cell holds (x, y), in the order they were placed
+		// the cells are conservative, f still decides whether the point is really inside
+		template <typename F>
+		void near(float x, float y, F&& f) const {
+			if (x < 0.0f || y < 0.0f || x >= _right || y >= _bottom)
+				return;
+
+			auto col = std::min(static_cast<std::size_t>(x / _right * cells), cells - 1);
+			auto row = std::min(static_cast<std::size_t>(y / _bottom * cells), cells - 1);
+
+			for (auto i : _cells[row * cells + col])
+				f(_items[i].first);
+		}
+
+	private:
+		// cells per side, a handful of items per cell for a screen of widgets
+		static const std::size_t cells = 8;
+
+		typename std::vector<std::pair<T, rect>>::iterator _find(const T& t) {
+			return std::find_if(_items.begin(), _items.end(), [&t](const std::pair<T, rect>& p) {
+				return p.first == t;
+			});
+		}
+
+		// the grid spans from (0, 0) to the furthest edge of any item, a point past that hits nothing
+		// a rect is listed in every cell it touches, widened by a unit so points on its top or left edge are kept
+		void _rebuild() {
+			_right = _bottom = 0.0f;
+			for (const auto& p : _items) {
+				_right = std::max(_right, p.second.left + p.second.width + 1.0f);
+				_bottom = std::max(_bottom, p.second.top + p.second.height + 1.0f);
+			}
+
+			for (auto& c : _cells)
+				c.clear();
+
+			if (_right <= 0.0f || _bottom <= 0.0f)
+				return;
+
+			auto cell = [](float v, float extent) -> std::size_t {
+				return static_cast<std::size_t>(std::min(std::max(v / extent * cells, 0.0f), cells - 1.0f));
+			};
+
+			for (std::size_t i = 0; i < _items.size(); i++) {
+				const auto& r = _items[i].second;
+
+				for (auto row = cell(r.top - 1.0f, _bottom); row <= cell(r.top + r.height, _bottom); row++)
+					for (auto col = cell(r.left - 1.0f, _right); col <= cell(r.left + r.width, _right); col++)
+						_cells[row * cells + col].push_back(static_cast<std::uint32_t>(i));
+			}
+		}
+
+		std::vector<std::pair<T, rect>> _items;
+		std::vector<std::uint32_t> _cells[cells * cells]; // indices into _items
+		float _right, _bottom;
+	};
+};
+
+#endif // !_HIT_GRID_HPP
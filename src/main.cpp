@@ -7,14 +7,21 @@
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <string>
 #include <array>
 #include <vector>
 
 #include "flashing_text.hpp"
+#include "batch.hpp"
 #include "operation.hpp"
 #include "resource.hpp"
 #include "manager.hpp"
+#include "numeric.hpp"
 #include "core.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
 // class responsible for rendering the game
@@ -40,6 +47,9 @@ private:
 	flashing_text _primary, _level, _moves, _target;
 	flashing_text _tutorial_textl1, _tutorial_textl2;
 
+	render_batch _batch;
+	level::mode _batched_mode;
+
 	template <typename T>
 	void _set_buttons(T& which, make_operations::type to) {
 		for (auto& it : which)
@@ -51,7 +61,9 @@ private:
 
 public:
 
-	game_renderer()=default;
+	game_renderer()
+		: _batched_mode(level::mode::numeric) {
+	}
 
 	virtual std::unique_ptr<sf::RenderWindow> setup() override {
 		sf::ContextSettings cset;
@@ -67,15 +79,23 @@ public:
 
 		auto win = util::make_unique<sf::RenderWindow>(vmode, "my_game", sf::Style::Titlebar | sf::Style::Close, cset);
 
-		// optimal resolution for text rendering (as tested) is 640x480
-		// hence 0.5 * ((x/640) + (y/480))
-		// hence (2x + 4y) / 1920*2
-		float font_scale_factor = (3.0f * win->getSize().x + 4.0f * win->getSize().x) / 3840.0f;
-
 		// set the window favicon from loaded favicon file - see int main()
 		auto& favicon = resource_manager<sf::Image>::get("favicon");
 		win->setIcon(favicon.getSize().x, favicon.getSize().y, favicon.getPixelsPtr());
 
+		prepare(win->getSize());
+
+		return win;
+	}
+
+	// lay out the buttons and text for a window of size then start the game
+	virtual void prepare(const sf::Vector2u& size) override {
+
+		// optimal resolution for text rendering (as tested) is 640x480
+		// hence 0.5 * ((x/640) + (y/480))
+		// hence (2x + 4y) / 1920*2
+		float font_scale_factor = (3.0f * size.x + 4.0f * size.x) / 3840.0f;
+
 		// some position calculations for buttons and text
 		// it's messy but creating a scene graph binary is too complex
 
@@ -83,23 +103,23 @@ public:
 			_cental_btns[i].set_style(button_style::default_grey);
 			_cental_btns[i].set_font(resource_manager<sf::Font>::get("roboto"), static_cast<unsigned int>(48 * font_scale_factor));
 			_cental_btns[i].set_bounds(sf::FloatRect(
-				(i / 3) * (win->getSize().x / 3),
-				(win->getSize().y / 4) * (1 + (i % 3)),
-				win->getSize().x / 3, win->getSize().y / 4));
+				(i / 3) * (size.x / 3),
+				(size.y / 4) * (1 + (i % 3)),
+				size.x / 3, size.y / 4));
 		}
 
 		for (std::size_t i = 0; i < _aux_btns.size(); i++) {
 			_aux_btns[i].set_style(button_style::default_orange);
 			_aux_btns[i].set_font(resource_manager<sf::Font>::get("roboto"), static_cast<unsigned int>(48 * font_scale_factor));
 			_aux_btns[i].set_bounds(sf::FloatRect(
-				(2 * win->getSize().x) / 3,
-				(win->getSize().y / 4) * (1 + (i % 3)),
-				win->getSize().x / 3, win->getSize().y / 4));
+				(2 * size.x) / 3,
+				(size.y / 4) * (1 + (i % 3)),
+				size.x / 3, size.y / 4));
 		}
 
 		for (auto it : { &_primary, &_moves, &_level, &_target, &_tutorial_textl1, &_tutorial_textl2 }) {
 			it->set_font(resource_manager<sf::Font>::get("roboto"), static_cast<unsigned int>(24 * font_scale_factor));
-			it->set_bounds(sf::FloatRect(16, 16, win->getSize().x - 32, win->getSize().y / 4 - 32));
+			it->set_bounds(sf::FloatRect(16, 16, size.x - 32, size.y / 4 - 32));
 			it->set_flash_mode(flash_mode::none);
 			it->set_colour(sf::Color::White);
 			it->set_string("");
@@ -118,31 +138,75 @@ public:
 
 		// bootstrap the level manager
 		level::load();
-
-		return win;
 	}
 
-	virtual void update(sf::RenderWindow* rw, float dt) override {
-		// draw buttons and 'fade' them. i.e. update their hover/press state
-		for (auto& it : _aux_btns) { it.fade(dt); rw->draw(it); }
-		for (auto& it : _cental_btns) { it.fade(dt); rw->draw(it); }
+	virtual void update(float dt) override {
+		// 'fade' buttons. i.e. update their hover/press state
+		for (auto& it : _aux_btns) it.fade(dt);
+		for (auto& it : _cental_btns) it.fade(dt);
 
-		// for a numeric level render primary/moves/target/level text
+		// for a numeric level update primary/moves/target/level text
 		if (level::last_mode() == level::mode::numeric) {
-			_moves.update(dt); rw->draw(_moves);
-			_target.update(dt); rw->draw(_target);
-			_level.update(dt); rw->draw(_level);
-			_primary.update(dt); rw->draw(_primary);
+			_moves.update(dt);
+			_target.update(dt);
+			_level.update(dt);
+			_primary.update(dt);
 		}
 
-		// for a tutorial level render line1/line2/level text
+		// for a tutorial level update line1/line2/level text
 		if (level::last_mode() == level::mode::tutorial) {
-			_tutorial_textl1.update(dt); rw->draw(_tutorial_textl1);
-			_tutorial_textl2.update(dt); rw->draw(_tutorial_textl2);
-			_level.update(dt); rw->draw(_level);
+			_tutorial_textl1.update(dt);
+			_tutorial_textl2.update(dt);
+			_level.update(dt);
 		}
 	};
 
+	// only what update() updates can animate
+	virtual bool animating() const override {
+		for (auto& it : _aux_btns) if (it.fading()) return true;
+		for (auto& it : _cental_btns) if (it.fading()) return true;
+
+		if (level::last_mode() == level::mode::numeric) {
+			for (auto it : { &_moves, &_target, &_level, &_primary })
+				if (it->flashing()) return true;
+		}
+
+		if (level::last_mode() == level::mode::tutorial) {
+			for (auto it : { &_tutorial_textl1, &_tutorial_textl2, &_level })
+				if (it->flashing()) return true;
+		}
+
+		return false;
+	}
+
+	// one draw call for the rects plus one per character size (see batch.hpp), rebuilt only when something looks different
+	virtual void draw(sf::RenderTarget& target) override {
+		if (_batch.stale() || _batched_mode != level::last_mode()) {
+			_batch.clear();
+			_batched_mode = level::last_mode();
+
+			for (auto& it : _aux_btns) it.batch(_batch);
+			for (auto& it : _cental_btns) it.batch(_batch);
+
+			// for a numeric level render primary/moves/target/level text
+			if (level::last_mode() == level::mode::numeric) {
+				_moves.batch(_batch);
+				_target.batch(_batch);
+				_level.batch(_batch);
+				_primary.batch(_batch);
+			}
+
+			// for a tutorial level render line1/line2/level text
+			if (level::last_mode() == level::mode::tutorial) {
+				_tutorial_textl1.batch(_batch);
+				_tutorial_textl2.batch(_batch);
+				_level.batch(_batch);
+			}
+		}
+
+		target.draw(_batch);
+	};
+
 	// replace existing central buttons
 	virtual void listen(const posts::display_event<posts::display_event_mode::operations_central>& t) override {
 		_set_buttons(_cental_btns, t.operations);
@@ -253,7 +317,85 @@ public:
 	}
 };
 
+// usage:
+// calculator_game [flags]                  play
+// calculator_game [flags] --record FILE    play, logging every input to FILE (see recording.hpp)
+// calculator_game [flags] --replay FILE    replay a logged game without a window, as fast as possible
+// flags:
+// --trace FILE     trace every event to FILE (see trace.hpp)
+// --busy           draw every frame as fast as it can, rather than sleeping while nothing moves
+//                  i.e. the game before it idled, with --fps 0 --tick 0 unless either is given
+// --fps N          draw at most N frames a second (default 60, 0 for no limit)
+// --vsync          draw in step with the display instead
+// --tick N         update animations N times a second whatever the frame rate (default 120, 0 for once a frame)
 int main(int argc, char* argv[]) {
+	std::string trace_path, flag, path;
+	core::run_options options;
+	bool paced = false, ticked = false; // whether --fps or --tick was given
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+
+		if ((arg == "--trace" || arg == "--record" || arg == "--replay") && i + 1 < argc) {
+			if (arg == "--trace")
+				trace_path = argv[++i];
+			else if (flag.empty()) {
+				flag = arg;
+				path = argv[++i];
+			}
+			else
+				flag = "--usage";
+		}
+		else if ((arg == "--fps" || arg == "--tick") && i + 1 < argc) {
+			int value;
+
+			try {
+				value = numeric::from_string(argv[++i]);
+			} catch (std::invalid_argument& e) {
+				value = -1;
+			}
+
+			if (value < 0)
+				flag = "--usage";
+			else if (arg == "--fps") {
+				options.fps = value;
+				paced = true;
+			}
+			else {
+				options.tick = value;
+				ticked = true;
+			}
+		}
+		else if (arg == "--busy")
+			options.idle = false;
+		else if (arg == "--vsync")
+			options.vsync = true;
+		else
+			flag = "--usage";
+	}
+
+	// the baseline idling is measured against, so neither capped nor stepped unless asked
+	if (!options.idle) {
+		if (!paced) options.fps = 0;
+		if (!ticked) options.tick = 0;
+	}
+
+	if (flag == "--usage") {
+		std::cerr << "usage: " << argv[0] << " [--trace FILE] [--busy] [--fps N | --vsync] [--tick N] [--record FILE | --replay FILE]" << std::endl;
+		return 2;
+	}
+
+	if (!trace_path.empty()) {
+#if defined(CALCULATOR_EVENT_TRACE)
+		if (!event::trace::capture(trace_path)) {
+			std::cerr << "error: can't write " << trace_path << std::endl;
+			return 2;
+		}
+#else
+		std::cerr << "error: --trace needs a build with CALCULATOR_EVENT_TRACE (cmake -DCALCULATOR_EVENT_TRACE=ON)" << std::endl;
+		return 2;
+#endif
+	}
 
 	// asynchronous loading for so few resources is unnecessary
 	// hence just preload
@@ -262,5 +404,36 @@ int main(int argc, char* argv[]) {
 
 	game_renderer g;
 
-	core::run(g);
+	try {
+		if (flag == "--replay") {
+			recording::player p(path);
+
+			auto start = std::chrono::steady_clock::now();
+			std::size_t frames = core::replay(g, p);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << "replayed " << frames << " frames in " << seconds << "s" << std::endl;
+		}
+		else {
+			auto stats = core::run(g, path, options);
+			stats.seconds = std::max(stats.seconds, 1e-6);
+
+			// idle is the share of time asleep, cpu the share of one core used
+			std::cout << "ran " << stats.frames << " frames in " << stats.seconds << "s, "
+				<< static_cast<int>(100 * stats.idle / stats.seconds) << "% idle, "
+				<< static_cast<int>(100 * stats.cpu / stats.seconds) << "% cpu" << std::endl;
+
+			const auto& j = stats.jitter;
+			std::cout << "frame ms: mean " << j.mean << " +/- " << j.deviation << ", p50 " << j.p50 << ", p99 " << j.p99
+				<< ", worst " << j.worst << ", " << j.late << " late" << std::endl;
+		}
+	} catch (std::runtime_error& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 2;
+	}
+
+#if defined(CALCULATOR_EVENT_TRACE)
+	event::trace::finish();
+	event::trace::report(std::cerr);
+#endif
 };
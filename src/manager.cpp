@@ -3,13 +3,10 @@
  * implements the game manager in manager.hpp
  */
 
+#include "recording_format.hpp"
 #include "manager.hpp"
 #include "operation.hpp"
-
-// specify storage of tutorial operation data within this translation unit
-// to do with the nature of statics in C++
-std::vector<std::pair<std::string, std::string>> default_operation::tutorial::_data;
-std::size_t default_operation::tutorial::_idx;
+#include "game.hpp"
 
 // setup the game state to match that of *this level
 void level::instantiate(std::size_t l) const {
@@ -38,7 +35,7 @@ void level::instantiate(std::size_t l) const {
 
 			// set level string and pass initialization to tutorial class (operation.hpp)
 			posts::text::numeric::set_level(_lvl);
-			default_operation::tutorial::initialize(tutorial_text);
+			default_operation::tutorial::initialize();
 			break;
 		default:
 			std::cout << "warning: unhandled level type" << std::endl;
@@ -77,7 +74,8 @@ namespace {
 		flash_mode_t get_mode() const { return _flash; }
 	};
 
-	// template that dispatches to the event manager only if Should is true
+	// template that queues with the event manager only if Should is true
+	// queued rather than posted, so a click's several posts reach the renderer after the click, in order (see event::drain)
 	template <typename T, bool Should>
 	struct auto_poster {
 		static void post(const T& t) { }
@@ -86,7 +84,7 @@ namespace {
 	template <typename T>
 	struct auto_poster<T, true> {
 		static void post(const T& t) {
-			event::dispatch<T>::post(std::move(t));
+			event::dispatch<T>::queue(t);
 		}
 	};
 
@@ -102,121 +100,40 @@ namespace {
 	std::string _tutorial_text; // current tutorial string
 
 	level::mode _last_mode; // last level type e.g. level::mode::numeric
-	std::size_t _lm_index = 0, // current level reached
-		_lm_max_index = 0; // highest level ever reached
-
-	// definition of all levels:
-	using namespace default_operation;
-	std::vector<std::shared_ptr<level>> _lm_lvls ({
-		std::make_shared<level>(level{
-			{ "below is a grid of buttons, click 'next'", "next" },
-			{ "once you enter the game those will look different", "next" },
-			{ "for example it might say +1 which means add one", "next" },
-			{ "that will add one to the big number", "next" },
-			{ "that number will be where this text is", "next" },
-			{ "above that there will be four pieces of text..", "next" },
-			{ "'level' is how far through the game you are", "next" },
-			{ "'moves' is how many moves you can do before you lose", "next" },
-			{ "'target' is what number you need to try get to", "next" },
-			{ "once you finish a level press the orange NEXT", "next" },
-			{ "if you mess up press to orange AC to restart", "next" },
-			{ "hopefully that helps!", "got it" }
-		}),
-
-		std::make_shared<level>(level{
-			{ "", "click me" },
-			{ "hello", "hi" },
-			{ "I'm a calculator", "okay" },
-			{ "and I need your help", "okay" },
-			{ "are you up for it?", "sure" },
-			{ "great! I'll give you a starting number", "okay" },
-			{ "and you need to reach the target number", "next" },
-			{ "the target number will be in the top right", "next" },
-			{ "to get to it you need to press buttons", "next" },
-			{ "if the button said '+1' it would add one", "next" },
-			{ "you also have a limited number of moves to reach the target", "next" },
-			{ "if you mess up press the orange AC to reset", "next" },
-			{ "once you finish a level click the orange NEXT", "next" },
-			{ "if you want to change level click MODE", "next" },
-			{ "and for more help click HELP", "next" },
-			{ "oh here's a problem now...", "" }
-		}),
-
-		std::make_shared<level>(0, 3, 3, make_operations(add(1))),
-
-		std::make_shared<level>(level{
-			{ "looks like you're already a master", "thanks" },
-			{ "see if you can do these...", "" }
-		}),
-
-		// starting number, moves allowed, target number, ....
-		std::make_shared<level>(2, 2, 5, make_operations(add(1), add(2))),
-		std::make_shared<level>(5, 3, 21, make_operations(add(7), add(2))),
-		std::make_shared<level>(10, 5, 2, make_operations(sub(7), add(2))),
-		std::make_shared<level>(-3, 3, -4, make_operations(sub(2), add(3))),
-		std::make_shared<level>(0, 3, 8, make_operations(mul(3), add(2))),
-		std::make_shared<level>(3, 4, -16, make_operations(mul(-2), add(2))),
-		std::make_shared<level>(4, 3, 126, make_operations(mul(6), sub(3))),
-		std::make_shared<level>(7, 4, 56, make_operations(mul(-4), add(7))),
-		std::make_shared<level>(100, 3, 5, make_operations(divi(5), add(5))),
-		std::make_shared<level>(52, 3, 12, make_operations(divi(2), sub(2))),
-		std::make_shared<level>(-3, 4, 190, make_operations(mul(5), add(10), add(3))),
-		std::make_shared<level>(2, 3, 256, make_operations(power(2))),
-		std::make_shared<level>(0, 3, 9, make_operations(power(2), sub(1), sub(2))),
-
-		std::make_shared<level>(level{
-			{ "you seem to know your arithmetic pretty well", "thanks" },
-			{ "but there's more to a calculator than just that", "like?" },
-			{ "a new button has been added... good luck", "" }
-		}),
-
-		std::make_shared<level>(2, 3, 2112, make_operations(cat(1), cat(2))),
-		std::make_shared<level>(8, 4, 888, make_operations(cat(2), add(6))),
-		std::make_shared<level>(0, 4, 42, make_operations(cat(1), mul(2))),
-		std::make_shared<level>(0, 10, 1011010, make_operations(cat(0), add(1))),
-		std::make_shared<level>(25, 4, 111, make_operations(cat(5), divi(5))),
-		std::make_shared<level>(3, 4, -5, make_operations(cat(2), add(4), divi(-4))),
-		std::make_shared<level>(3, 5, 8, make_operations(cat(2), divi(-4), sub(5))),
-		std::make_shared<level>(0, 3, 144, make_operations(power(2), sub(1), cat(2))),
-
-		std::make_shared<level>(level{
-			{ "that button adds number, this new button deletes them", "" }
-		}),
-
-		std::make_shared<level>(111, 2, 1, make_operations(del())),
-		std::make_shared<level>(123, 3, 2, make_operations(del(), mul(2))),
-		std::make_shared<level>(-25, 3, -9, make_operations(del(), sub(6))),
-		std::make_shared<level>(0, 6, -5, make_operations(del(), cat(2), sub(6))),
-
-		std::make_shared<level>(level{
-			{ "one more button has been added, good luck!", "" }
-		}),
-
-		std::make_shared<level>(-5, 1, 5, make_operations(sign_invert())),
-		std::make_shared<level>(0, 3, -6, make_operations(sign_invert(), add(4), add(2))),
-		std::make_shared<level>(0, 4, -13, make_operations(sign_invert(), add(3), sub(7))),
-		std::make_shared<level>(0, 4, 60, make_operations(sign_invert(), add(5), sub(10), mul(4))),
-		std::make_shared<level>(44, 5, 52, make_operations(sign_invert(), add(9), divi(2), mul(4))),
-		std::make_shared<level>(9, 5, 10, make_operations(sign_invert(), add(5), mul(5))),
-
-		std::make_shared<level>(level{
-			{ "there are only a few questions left", "wow" },
-			{ "you could actually win this thing", "phew" },
-			{ "good luck...", "" }
-		}),
-
-		std::make_shared<level>(14, 5, 12, make_operations(sign_invert(), cat(6), add(5), divi(8))),
-		std::make_shared<level>(55, 4, 13, make_operations(sign_invert(), del(), add(9))),
-		std::make_shared<level>(0, 5, 245, make_operations(sign_invert(), cat(5), sub(3), mul(4))),
-		std::make_shared<level>(39, 4, 12, make_operations(sign_invert(), mul(-3), divi(3), add(9))),
-		std::make_shared<level>(111, 6, 126, make_operations(sign_invert(), del(), mul(3), sub(9))),
-
-		std::make_shared<level>(level{
-			{ "thanks to you all the questions have been solved", "yay!" },
-			{ "you're pretty great!", "thanks" },
-			{ "well, I have to go... bye!", "cya" }
-		})
-	});
+	game::session _session; // current level, highest level reached and the progress through the one being played
+
+	// every level of game.hpp as something the renderer can show
+	// numeric levels get a button class for each of their opcodes
+	std::vector<std::shared_ptr<level>> load_levels() {
+		std::vector<std::shared_ptr<level>> ret;
+
+		for (const auto& l : game::levels()) {
+			if (l.is_tutorial()) {
+				ret.push_back(std::make_shared<level>(l.tutorial));
+				continue;
+			}
+
+			make_operations::type operations;
+			for (auto op : l.operations)
+				operations.push_back(default_operation::from_opcode(op));
+
+			ret.push_back(std::make_shared<level>(l.primary, l.moves, l.target, operations));
+		}
+
+		return ret;
+	}
+
+	std::vector<std::shared_ptr<level>> _lm_lvls = load_levels();
+
+	// tell anyone recording (see core::run) what the game did to the current level
+	void note(recording::note::kind what, std::size_t button=0, game::verdict v=game::verdict::playing) {
+		event::dispatch<recording::note>::post({
+			what,
+			static_cast<std::uint16_t>(_session.selected()),
+			static_cast<std::uint8_t>(button),
+			static_cast<std::uint8_t>(v)
+		});
+	}
 };
 
 // implementation of posts
@@ -374,8 +291,8 @@ namespace posts {
 		// ignore input on central buttons
 		// done so by dispatching a separate event to the renderer
 		// hence the renderer will call disable on managed buttons
-		void disable_central() { event::dispatch<display_event<display_event_mode::disable>>::post({ display_event_mode::operations_central, true }); }
-		void enable_central() { event::dispatch<display_event<display_event_mode::disable>>::post({ display_event_mode::operations_central, false }); }
+		void disable_central() { event::dispatch<display_event<display_event_mode::disable>>::queue({ display_event_mode::operations_central, true }); }
+		void enable_central() { event::dispatch<display_event<display_event_mode::disable>>::queue({ display_event_mode::operations_central, false }); }
 
 
 		// pass operation data to the game renderer
@@ -401,35 +318,35 @@ namespace posts {
 	};
 };
 
-// instantiate the current level (given by _lm_index)
+// instantiate the current level (selected in _session)
 void level::run() {
-	_last_mode = _lm_lvls[_lm_index]->type;
-	_lm_lvls[_lm_index]->instantiate(_lm_index);
+	std::size_t index = _session.selected();
+
+	_session.start();
+	note(recording::note::kind::start);
+
+	_last_mode = _lm_lvls[index]->type;
+	_lm_lvls[index]->instantiate(index);
 }
 
 // reset the game by starting at level 1
 // level 0 represents the instructions screen
 void level::load() {
-	_lm_index = _lm_max_index = 1;
+	_session.go(1);
 
 	// even though it shouldn't really be possible
 	// the game is a little more fun when you can skip a level
-	_lm_max_index = _lm_lvls.size() - 2;
+	_session.unlock(_lm_lvls.size() - 2);
 
 	level::run();
 }
 
 // go to the next level
 void level::next(bool instantiate) {
-	_lm_index++;
-
-	// update the max index if so required
-	if (_lm_index > _lm_max_index)
-		_lm_max_index = _lm_index;
 
 	// when the final level is finished
 	// quit
-	if (_lm_index >= _lm_lvls.size())
+	if (!_session.next())
 		std::exit(0);
 
 	if (instantiate)
@@ -438,9 +355,7 @@ void level::next(bool instantiate) {
 
 // go to the previous level
 void level::previous(bool instantiate) {
-	// ensure no underflows
-	if (_lm_index > 0)
-		_lm_index--;
+	_session.previous();
 
 	if (instantiate)
 		level::run();
@@ -448,26 +363,44 @@ void level::previous(bool instantiate) {
 
 // run the instructions level
 void level::load_instructions() {
-	_lm_index = 0;
+	_session.go(0);
 
 	level::run();
 
 	// reset to the last (highest) level
 	// somewhat problematic, but far simpler than an alt solution
-	_lm_index = _lm_max_index - 1;
+	// the instructions stay in play until another level is run
+	_session.go(_session.max() - 1);
 }
 
 // re-run the current level
 void level::reset() {
+	note(recording::note::kind::reset);
 	level::run();
 }
 
+// press op, noting which button of the level it was
+// two buttons with the same operation do the same thing, so the first match stands for either
+game::verdict level::press(numeric::opcode op) {
+	const auto& ops = _session.current().operations;
+
+	std::size_t button = 0;
+	while (button < ops.size() && (ops[button].type != op.type || ops[button].n != op.n))
+		button++;
+
+	auto result = _session.press(op);
+	note(recording::note::kind::press, button, result);
+
+	return result;
+}
+
 // get the current level
 level* level::get() {
-	return _lm_lvls[_lm_index].get();
+	return _lm_lvls[_session.selected()].get();
 }
 
 // return level data
-std::size_t level::get_current() { return _lm_index; }
-std::size_t level::get_max() { return _lm_max_index; }
+std::size_t level::get_current() { return _session.selected(); }
+std::size_t level::get_max() { return _session.max(); }
 level::mode level::last_mode() { return _last_mode; }
+game::session& level::session() { return _session; }
@@ -14,6 +14,7 @@
 
 #include "flashing_text.hpp"
 #include "event.hpp"
+#include "game.hpp"
 #include "util.hpp"
 
 // a game level's data
@@ -194,6 +195,12 @@ namespace posts {
 	};
 };
 
+// text events are whole snapshots, so of several queued in a frame only the last matters
+namespace event {
+	template <> struct coalesce<posts::display_event<posts::display_event_mode::normal_text>> : std::true_type { };
+	template <> struct coalesce<posts::display_event<posts::display_event_mode::tutorial_text>> : std::true_type { };
+};
+
 // a level instance and also a static level management behavior
 struct level {
 	// a level may store either numeric or tutorial data
@@ -236,6 +243,14 @@ struct level {
 	// get the last mode given to a level
 	static mode last_mode() /* const */;
 
+	// press an operation on the level being played, see game::session::press()
+	// also posts a recording::note of the press, as run() and reset() do for theirs
+	static game::verdict press(numeric::opcode op);
+
+	// get the session behind the level manager
+	// holds which level is selected and the numbers and tutorial progress of the one being played
+	static game::session& session();
+
 	// payload attached to a level:
 
 	const mode type;
@@ -249,7 +264,7 @@ struct level {
 	}
 
 	// construct a tutorial level
-	level(std::initializer_list<std::pair<std::string, std::string>> l)
+	level(const std::vector<std::pair<std::string, std::string>>& l)
 		: type(mode::tutorial), primary(-1), moves(-1), target(-1),
 		operations{},
 		tutorial_text{l}, _idx(0) {
@@ -0,0 +1,81 @@
+/*
+ * mpsc.hpp:
+ * a lock free queue that any number of threads push to and one thread pops from
+ * a linked list of nodes after Dmitry Vyukov's intrusive MPSC queue:
+ * a push is one atomic exchange and never waits, a pop never waits either,
+ * though it may miss a push still being linked in until the next pop
+ */
+
+#ifndef _MPSC_HPP
+#define _MPSC_HPP
+
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <new>
+
+namespace util {
+
+	template <typename T>
+	class mpsc_queue {
+	public:
+		mpsc_queue()
+			: _head(new node()), _tail(_head.load()) {
+		}
+
+		mpsc_queue(const mpsc_queue&)=delete;
+		mpsc_queue& operator=(const mpsc_queue&)=delete;
+
+		~mpsc_queue() {
+			while (pop([](T&) { }));
+			delete _tail;
+		}
+
+		// from any thread
+		void push(const T& t) {
+			node* n = new node();
+			new (&n->value) T(t);
+
+			node* prev = _head.exchange(n, std::memory_order_acq_rel);
+			prev->next.store(n, std::memory_order_release);
+		}
+
+		// from the one consuming thread: whether anything has been pushed that pop() hasn't taken
+		// counts a push still being linked in, which the next pop() may yet miss
+		bool empty() const {
+			return _head.load(std::memory_order_acquire) == _tail;
+		}
+
+		// from the one consuming thread: call f on the oldest value and remove it
+		// returns false when there was none
+		template <typename F>
+		bool pop(F&& f) {
+			node* next = _tail->next.load(std::memory_order_acquire);
+			if (!next)
+				return false;
+
+			T* value = reinterpret_cast<T*>(&next->value);
+			f(*value);
+			value->~T();
+
+			// next becomes the empty node at the tail
+			delete _tail;
+			_tail = next;
+
+			return true;
+		}
+
+	private:
+		struct node {
+			std::atomic<node*> next;
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type value; // empty in the node at the tail
+
+			node() : next(nullptr) { }
+		};
+
+		std::atomic<node*> _head; // the last pushed, where producers append
+		node* _tail; // only touched by the consumer
+	};
+};
+
+#endif // !_MPSC_HPP
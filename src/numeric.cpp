@@ -0,0 +1,298 @@
+/*
+ * numeric.cpp:
+ * implements the parts of numeric.hpp that are too big to inline
+ */
+
+#include "numeric.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+	// does s start with prefix
+	bool starts_with(const std::string& s, const std::string& prefix) {
+		return s.compare(0, prefix.size(), prefix) == 0;
+	}
+
+	// press an operation on each number one at a time
+	// handles the operations without a vector kernel and the tail of those with one
+	void apply_scalar(numeric::opcode op, const int* in, int* out, std::uint8_t* ok, std::size_t count) {
+		for (std::size_t i = 0; i < count; i++) {
+			int result = 0;
+			ok[i] = op.apply(in[i], result);
+			out[i] = result;
+		}
+	}
+
+#if defined(__AVX2__)
+
+	// truncated x / n of eight lanes
+	// AVX2 has no integer divide, but a double holds every int exactly
+	// so dividing as doubles and truncating gives the same quotient as the / operator
+	__m256i div_epi32(__m256i x, __m256d n) {
+		__m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), n));
+		__m128i hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), n));
+
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+	}
+
+	// one bit per lane of a comparison, set where the comparison held
+	int lanes(__m256i mask) {
+		return _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+	}
+
+	// one bit per lane, set where a product of x and n fits in an int
+	// products are taken as doubles, which are exact up to 2^53 and far out of range past it
+	int product_fits(__m256i x, __m256d n) {
+		const __m256d max = _mm256_set1_pd(std::numeric_limits<int>::max());
+		const __m256d min = _mm256_set1_pd(std::numeric_limits<int>::min());
+
+		__m256d lo = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), n);
+		__m256d hi = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), n);
+
+		int fits_lo = _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(lo, max, _CMP_LE_OQ), _mm256_cmp_pd(lo, min, _CMP_GE_OQ)));
+		int fits_hi = _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(hi, max, _CMP_LE_OQ), _mm256_cmp_pd(hi, min, _CMP_GE_OQ)));
+
+		return fits_lo | (fits_hi << 4);
+	}
+
+	// press an operation on eight numbers at a time
+	// returns how many numbers were handled, the rest are left to apply_scalar()
+	// failures match numeric.hpp exactly, so lanes that overflow are not ok
+	std::size_t apply_avx2(numeric::opcode op, const int* in, int* out, std::uint8_t* ok, std::size_t count) {
+		typedef numeric::opcode::kind kind;
+		const int int_max = std::numeric_limits<int>::max(), int_min = std::numeric_limits<int>::min();
+
+		// operations without a kernel or that always fail
+		switch (op.type) {
+			case kind::divi: case kind::mod: if (op.n == 0) return 0; break;
+			case kind::cat: case kind::power: return 0;
+			default: break;
+		}
+
+		const __m256i n = _mm256_set1_epi32(op.n), smallest = _mm256_set1_epi32(int_min);
+		const __m256d n_pd = _mm256_set1_pd(op.type == kind::del ? 10.0 : static_cast<double>(op.n));
+
+		// the numbers past which adding or subtracting N overflows
+		// which side of the range they sit on depends on the sign of N
+		const __m256i add_limit = _mm256_set1_epi32((op.n >= 0) ? int_max - op.n : int_min - op.n);
+		const __m256i sub_limit = _mm256_set1_epi32((op.n > 0) ? int_min + op.n : int_max + op.n);
+
+		std::size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), y, q;
+			int fine = 0xff;
+
+			switch (op.type) {
+				case kind::add:
+					y = _mm256_add_epi32(x, n);
+					fine = ~lanes((op.n >= 0) ? _mm256_cmpgt_epi32(x, add_limit) : _mm256_cmpgt_epi32(add_limit, x));
+					break;
+
+				case kind::sub:
+					y = _mm256_sub_epi32(x, n);
+					fine = ~lanes((op.n > 0) ? _mm256_cmpgt_epi32(sub_limit, x) : _mm256_cmpgt_epi32(x, sub_limit));
+					break;
+
+				case kind::mul:
+					y = _mm256_mullo_epi32(x, n);
+					fine = product_fits(x, n_pd);
+					break;
+
+				// the smallest int has no positive counterpart
+				case kind::sign_invert:
+					y = _mm256_sub_epi32(_mm256_setzero_si256(), x);
+					fine = ~lanes(_mm256_cmpeq_epi32(x, smallest));
+					break;
+
+				case kind::sign_posative:
+					y = _mm256_abs_epi32(x);
+					fine = ~lanes(_mm256_cmpeq_epi32(x, smallest));
+					break;
+
+				case kind::del:
+					y = div_epi32(x, n_pd);
+					break;
+
+				// the remainder is whatever the quotient doesn't cover
+				// including the smallest int mod -1, where the quotient wraps but the remainder is still 0
+				case kind::mod:
+					q = div_epi32(x, n_pd);
+					y = _mm256_sub_epi32(x, _mm256_mullo_epi32(q, n));
+					break;
+
+				// a quotient is exact when multiplying it back gives the original number
+				// apart from the smallest int / -1, which overflows
+				case kind::divi:
+					y = div_epi32(x, n_pd);
+					fine = lanes(_mm256_cmpeq_epi32(_mm256_mullo_epi32(y, n), x));
+
+					if (op.n == -1)
+						fine &= ~lanes(_mm256_cmpeq_epi32(x, smallest));
+					break;
+
+				default:
+					return i;
+			}
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), y);
+
+			for (int lane = 0; lane < 8; lane++)
+				ok[i + lane] = (fine >> lane) & 1;
+		}
+
+		return i;
+	}
+
+#endif
+};
+
+namespace numeric {
+
+	// string -> int, the whole string must be a (possibly signed) number
+	int from_string(const std::string& s) {
+		std::size_t used = 0;
+		int ret;
+
+		try {
+			ret = std::stoi(s, &used);
+		} catch (std::exception& e) {
+			throw std::invalid_argument("not a number: " + s);
+		}
+
+		if (used != s.size())
+			throw std::invalid_argument("not a number: " + s);
+
+		return ret;
+	}
+
+	// can every number that leads to a result be enumerated
+	bool opcode::invertible() const {
+		switch (type) {
+			case kind::mod: return false;
+			case kind::mul: return n != 0;
+			case kind::power: return n > 0;
+			default: return true;
+		}
+	}
+
+	// append every number that this operation takes to result
+	// candidates are worked out in long long then confirmed by applying the operation forwards
+	// so that the inverse can never disagree with apply()
+	void opcode::preimages(int result, std::vector<int>& out) const {
+		long long y = result, candidates[20];
+		std::size_t count = 0;
+
+		switch (type) {
+			case kind::add: candidates[count++] = y - n; break;
+			case kind::sub: candidates[count++] = y + n; break;
+			case kind::mul: if (n != 0 && y % n == 0) candidates[count++] = y / n; break;
+			case kind::divi: candidates[count++] = y * n; break;
+			case kind::sign_invert: candidates[count++] = -y; break;
+			case kind::sign_posative: candidates[count++] = y; candidates[count++] = -y; break;
+
+			// strip the digits of N, when they match the trailing digits of result
+			case kind::cat: {
+				long long digits = std::abs(static_cast<long long>(n)), shift = 1;
+				for (long long d = digits; d != 0 || shift == 1; d /= 10)
+					shift *= 10;
+
+				long long magnitude = std::abs(y) - digits;
+				if (magnitude >= 0 && magnitude % shift == 0)
+					candidates[count++] = (y < 0 ? -1 : 1) * magnitude / shift;
+				break;
+			}
+
+			// any number with result as all but its last digit
+			case kind::del:
+				for (int d = -9; d <= 9; d++)
+					candidates[count++] = y * 10 + d;
+				break;
+
+			// the integral nth roots, either side of the floating point estimate
+			case kind::power: {
+				long long root = std::llround(std::pow(std::abs(static_cast<double>(y)), 1.0 / n));
+				for (long long r = std::max(0LL, root - 1); r <= root + 1; r++) {
+					candidates[count++] = r;
+					candidates[count++] = -r;
+				}
+				break;
+			}
+
+			// not invertible
+			case kind::mod:
+				break;
+		}
+
+		for (std::size_t i = 0; i < count; i++) {
+			int on, check;
+			if (candidates[i] < std::numeric_limits<int>::min() || candidates[i] > std::numeric_limits<int>::max())
+				continue;
+
+			on = static_cast<int>(candidates[i]);
+			if (apply(on, check) && check == result && std::find(out.begin(), out.end(), on) == out.end())
+				out.push_back(on);
+		}
+	}
+
+	// the string drawn on the button
+	// must match get_string() of the classes in default_operation
+	std::string opcode::get_string() const {
+		switch (type) {
+			case kind::add: return "+" + std::to_string(n);
+			case kind::sub: return "-" + std::to_string(n);
+			case kind::mul: return "x" + std::to_string(n);
+			case kind::divi: return "/" + std::to_string(n);
+			case kind::mod: return "%" + std::to_string(n);
+			case kind::cat: return ".." + std::to_string(n);
+			case kind::del: return "<<";
+			case kind::sign_invert: return "+/-";
+			case kind::sign_posative: return "|x|";
+			case kind::power: return "x^" + std::to_string(n);
+		}
+
+		return "";
+	}
+
+	// the inverse of get_string()
+	// fixed strings and longer prefixes are checked first as "+/-" also starts with "+"
+	opcode opcode::from_string(const std::string& s) {
+		if (s == "<<") return { kind::del, 0 };
+		if (s == "+/-") return { kind::sign_invert, 0 };
+		if (s == "|x|") return { kind::sign_posative, 0 };
+
+		if (starts_with(s, "x^")) return { kind::power, numeric::from_string(s.substr(2)) };
+		if (starts_with(s, "..")) return { kind::cat, numeric::from_string(s.substr(2)) };
+
+		if (s.size() > 1) {
+			switch (s[0]) {
+				case '+': return { kind::add, numeric::from_string(s.substr(1)) };
+				case '-': return { kind::sub, numeric::from_string(s.substr(1)) };
+				case 'x': return { kind::mul, numeric::from_string(s.substr(1)) };
+				case '/': return { kind::divi, numeric::from_string(s.substr(1)) };
+				case '%': return { kind::mod, numeric::from_string(s.substr(1)) };
+				default: break;
+			}
+		}
+
+		throw std::invalid_argument("unknown operation: " + s);
+	}
+
+	// press one operation on every number of a contiguous array
+	void apply_batch(opcode op, const int* in, int* out, std::uint8_t* ok, std::size_t count) {
+		std::size_t done = 0;
+
+#if defined(__AVX2__)
+		done = apply_avx2(op, in, out, ok, count);
+#endif
+
+		apply_scalar(op, in + done, out + done, ok + done, count - done);
+	}
+};
@@ -0,0 +1,198 @@
+/*
+ * numeric.hpp:
+ * the arithmetic behind every numeric operation, without any rendering or game state
+ * and a compact opcode to store and evaluate operations without virtual calls
+ * used by the numeric buttons in operation.hpp and by the headless tools
+ */
+
+#ifndef _NUMERIC_HPP
+#define _NUMERIC_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace numeric {
+
+	// every function below reports failure instead of throwing
+	// returning false (leaving out untouched) wherever the game would show ERR!
+	// i.e. a result that is a float, or that doesn't fit in an int
+
+	// narrow a wider result back to an int
+	inline bool fits(long long result, int& out) {
+		if (result < std::numeric_limits<int>::min() || result > std::numeric_limits<int>::max())
+			return false;
+
+		out = static_cast<int>(result);
+		return true;
+	}
+
+	// add N
+	inline bool add(int on, int n, int& out) { return fits(static_cast<long long>(on) + n, out); }
+
+	// subtract N
+	inline bool sub(int on, int n, int& out) { return fits(static_cast<long long>(on) - n, out); }
+
+	// multiply by N
+	inline bool mul(int on, int n, int& out) { return fits(static_cast<long long>(on) * n, out); }
+
+	// divide by N
+	// fails if that would produce a float e.g. 5/2
+	inline bool divi(int on, int n, int& out) {
+		if (n == 0 || (n == -1 && on == std::numeric_limits<int>::min()) || on % n != 0)
+			return false;
+
+		out = on / n;
+		return true;
+	}
+
+	// mod N
+	// fails for a mod by zero
+	inline bool mod(int on, int n, int& out) {
+		if (n == 0)
+			return false;
+
+		// anything mod -1 is zero, but the smallest int % -1 traps on most cpus
+		out = (n == -1) ? 0 : on % n;
+		return true;
+	}
+
+	// append the digits of N to the end
+	// e.g:
+	// 0 ... 2 -> 2
+	// 42 ... 0 -> 420
+	// 1234 ... 56 -> 123456
+	inline bool cat(int on, int n, int& out) {
+		long long magnitude = std::abs(static_cast<long long>(on));
+		long long digits = std::abs(static_cast<long long>(n)), shift = 1;
+
+		// find the power of ten that makes room for every digit of N
+		for (long long d = digits; d != 0 || shift == 1; d /= 10)
+			shift *= 10;
+
+		// check before multiplying, as even a long long can't hold every int times 10^10
+		if (magnitude > (static_cast<long long>(std::numeric_limits<int>::max()) + 1) / shift)
+			return false;
+
+		return fits(((on < 0) ? -1 : 1) * (magnitude * shift + digits), out);
+	}
+
+	// remove the last digit from the end
+	// semantically the same as x // 10
+	inline bool del(int on, int& out) { out = on / 10; return true; }
+
+	// x * -1. multiply by -1
+	inline bool sign_invert(int on, int& out) { return fits(-static_cast<long long>(on), out); }
+
+	// |x|. take the absolute value of x
+	inline bool sign_posative(int on, int& out) { return fits(std::abs(static_cast<long long>(on)), out); }
+
+	// x^n. raise x to the nth power
+	// fails for a negative power that makes a fraction e.g. 2^-1
+	inline bool power(int on, int n, int& out) {
+
+		// x^0, 1^n and -1^n never overflow and can't make a fraction
+		if (n == 0 || on == 1) { out = 1; return true; }
+		if (on == -1) { out = (n % 2 == 0) ? 1 : -1; return true; }
+
+		// the rest only make an int for a positive power
+		if (n < 0)
+			return false;
+
+		// 0^n for a positive n, which would otherwise loop n times as 0 never overflows
+		if (on == 0) { out = 0; return true; }
+
+		// any number but 0, 1 and -1 at least doubles each multiplication, so overflows within 32
+		long long result = 1;
+		for (int i = 0; i < n; i++) {
+			result *= on;
+
+			if (!fits(result, out))
+				return false;
+		}
+
+		return true;
+	}
+
+	// string -> int, the whole string must be a (possibly signed) number
+	// throws std::invalid_argument on garbage
+	int from_string(const std::string& s);
+
+	// a devirtualized numeric operation: which function above to call and its N
+	// every numeric class of default_operation converts to and from one of these
+	// so that an operation set can live in a contiguous array
+	struct opcode {
+		enum class kind : std::uint8_t {
+			add,
+			sub,
+			mul,
+			divi,
+			mod,
+			cat,
+			del,
+			sign_invert,
+			sign_posative,
+			power
+		};
+
+		kind type;
+		int n;
+
+		// press this operation on a number
+		// returns false when the game would show ERR! e.g. 5/2 or an overflow
+		bool apply(int on, int& out) const {
+			switch (type) {
+				case kind::add: return numeric::add(on, n, out);
+				case kind::sub: return numeric::sub(on, n, out);
+				case kind::mul: return numeric::mul(on, n, out);
+				case kind::divi: return numeric::divi(on, n, out);
+				case kind::mod: return numeric::mod(on, n, out);
+				case kind::cat: return numeric::cat(on, n, out);
+				case kind::del: return numeric::del(on, out);
+				case kind::sign_invert: return numeric::sign_invert(on, out);
+				case kind::sign_posative: return numeric::sign_posative(on, out);
+				case kind::power: return numeric::power(on, n, out);
+			}
+
+			return false;
+		}
+
+		// can every number that leads to a result be enumerated
+		// false for mod and for x0 or x^0 which collapse unbounded inputs onto one result
+		bool invertible() const;
+
+		// append every number that this operation takes to result
+		// e.g. the preimages of 12 under ..2 are { 1 } and under << are { 120...129 }
+		void preimages(int result, std::vector<int>& out) const;
+
+		// the string drawn on the button e.g. "+1" or "x^2"
+		std::string get_string() const;
+
+		// the inverse of get_string(), throws std::invalid_argument on garbage
+		static opcode from_string(const std::string& s);
+	};
+
+	// press every operation of a contiguous set on one number
+	// successful results are packed into out with the index of their operation in press
+	// returns how many were packed, at most count
+	inline std::size_t expand(const opcode* ops, std::size_t count, int on, int* out, std::size_t* press) {
+		std::size_t found = 0;
+
+		for (std::size_t i = 0; i < count; i++) {
+			if (ops[i].apply(on, out[found]))
+				press[found++] = i;
+		}
+
+		return found;
+	}
+
+	// press one operation on every number of a contiguous array
+	// ok[i] is 0 where the game would show ERR! e.g. /2 on an odd number, otherwise 1
+	// uses AVX2 kernels when compiled with them (see CALCULATOR_AVX2) and a scalar loop otherwise
+	// in, out and ok must each hold count elements, in and out may be the same array
+	void apply_batch(opcode op, const int* in, int* out, std::uint8_t* ok, std::size_t count);
+};
+
+#endif // !_NUMERIC_HPP
@@ -7,20 +7,16 @@
 #ifndef _OPERATION_HPP
 #define _OPERATION_HPP
 
+#include <functional>
 #include <stdexcept>
 #include <iostream>
 #include <string>
 #include <memory>
 
 #include "manager.hpp"
+#include "numeric.hpp"
 #include "button.hpp"
-
-// if an operation fails, throw this
-// e.g. 5/2 throws an exception due to it's resulting float
-struct operation_exception : public std::runtime_error {
-	operation_exception(const std::string& what_arg="op err") : std::runtime_error(what_arg) {}
-	virtual const char* what() const noexcept override { return std::runtime_error::what(); }
-};
+#include "game.hpp"
 
 // the abstract base that's polymorphically attached to buttons
 class basic_operation {
@@ -121,29 +117,31 @@ namespace default_operation {
 	public:
 		tutorial(const std::string& s) : text(s) { }
 
-		// bootstrap this give some tutorial data
-		static void initialize(const std::vector<std::pair<std::string, std::string>>& pairs) {
-			if (pairs.size() == 0)
+		// bootstrap this with the tutorial level the session has just started
+		static void initialize() {
+			if (level::session().current().tutorial.size() == 0)
 				throw std::logic_error("blank tutorial");
 
-			_idx = 0;
-			_data = pairs;
 			update();
 		}
 
 		// update the tutorial: go to the next string
+		// the text and how far through it are kept by the session (see game.hpp)
 		static void update() {
+			auto& s = level::session();
+			const auto& data = s.current().tutorial;
 
 			// generate instances of tutorial and update primary text
 			// until the tutorial is finished, in which case:
 			// show a next button
-			if (_idx >= _data.size() - 1) {
-				posts::tutorial_text::set(_data[_idx].first);
+			if (s.tutorial_index() >= data.size() - 1) {
+				posts::tutorial_text::set(data[s.tutorial_index()].first);
 				posts::operations::set_central(make_operations());
 				posts::operations::disable_central();
 				posts::operations::set_just_next();
 			} else {
-				auto& p = _data[_idx++];
+				auto& p = data[s.tutorial_index()];
+				s.advance();
 				posts::tutorial_text::set(p.first);
 				posts::operations::set_central(make_operations(tutorial(p.second)));
 			}
@@ -153,12 +151,6 @@ namespace default_operation {
 		virtual void call(level* l) override {
 			tutorial::update();
 		}
-
-	private:
-
-		// storage specified in manager.cpp
-		static std::vector<std::pair<std::string, std::string>> _data;
-		static std::size_t _idx;
 	};
 
 	// an operation that calls a lambda literal
@@ -230,19 +222,18 @@ namespace default_operation {
 
 // definition of an operation that operates on a number
 // used to simplify the definition of all numerics
+// the rules themselves are game::press() in game.hpp, shared with the headless tools
 class numeric_operation : public basic_operation {
 	virtual std::string get_string() const noexcept override=0;
-	virtual int perform(int on)=0;
 
-	// on click make call to perform and modify game based on resulting WIN/ERR/LOSE state
+	// on click press the operation on the session and modify game based on resulting WIN/ERR/LOSE state
 	virtual void call(level* l) override {
-		int result;
+		auto result = level::press(this->to_opcode());
+		const auto& s = level::session().numbers();
 
-		// attempt to perform the operation on the current primary
-		// if it fails set the ERR! string and place an AC button
-		try {
-			result = this->perform(posts::text::numeric::get_primary());
-		} catch (operation_exception& e) {
+		// if the operation failed on the current primary
+		// set the ERR! string and place an AC button
+		if (result == game::verdict::err) {
 			posts::text::string::set_primary("ERR!", flash_mode::indefinite | flash_mode::slow);
 			posts::operations::disable_central();
 			posts::operations::set_generic_ac();
@@ -250,16 +241,16 @@ class numeric_operation : public basic_operation {
 			return;
 		}
 
-		std::cout << "performed " << posts::text::numeric::get_primary() << " " << this->get_string() << " = " << result << std::endl;
+		std::cout << "performed " << posts::text::numeric::get_primary() << " " << this->get_string() << " = " << s.primary << std::endl;
 
 		// flash an update to the primary int
 		// and decrease the moves by 1
-		posts::text::numeric::set_primary<false>(result, flash_mode::one_shot | flash_mode::quick);
-		posts::text::numeric::set_moves<false>(posts::text::numeric::get_moves() - 1);
+		posts::text::numeric::set_primary<false>(s.primary, flash_mode::one_shot | flash_mode::quick);
+		posts::text::numeric::set_moves<false>(s.moves);
 
 		// if the target number has been reached:
 		// set WIN text and place a NEXT button
-		if (posts::text::numeric::get_target() == posts::text::numeric::get_primary()) {
+		if (result == game::verdict::win) {
 			posts::text::string::set_primary<false>("WIN!", flash_mode::indefinite | flash_mode::slow);
 			posts::text::secondary_string::set<false>(util::as_string(posts::text::numeric::get_primary()));
 			posts::text::post();
@@ -270,7 +261,7 @@ class numeric_operation : public basic_operation {
 
 		// if the moves dips below zero
 		// set LOSE text and place a AC button
-		else if (posts::text::numeric::get_moves() <= 0) {
+		else if (result == game::verdict::lose) {
 			posts::text::string::set_moves<false>(posts::text::string::get_moves(), flash_mode::thrice | flash_mode::quick);
 			posts::text::string::set_primary<false>("LOSE!", flash_mode::indefinite | flash_mode::slow);
 			posts::text::secondary_string::set<false>(util::as_string(posts::text::numeric::get_primary()));
@@ -283,6 +274,10 @@ class numeric_operation : public basic_operation {
 		// simply post previous update to primary/moves
 		else posts::text::post();
 	}
+
+public:
+	// the devirtualized form of this operation, see numeric.hpp
+	virtual numeric::opcode to_opcode() const noexcept=0;
 };
 
 namespace default_operation {
@@ -292,7 +287,7 @@ namespace default_operation {
 	public:
 		explicit add(int n) : _n(n) { }
 		virtual std::string get_string() const noexcept override { return "+" + util::as_string(_n); }
-		virtual int perform(int on) override { return on + _n; }
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::add, _n }; }
 	private:
 		int _n;
 	};
@@ -302,7 +297,7 @@ namespace default_operation {
 	public:
 		explicit sub(int n) : _n(n) { }
 		virtual std::string get_string() const noexcept override { return "-" + util::as_string(_n); }
-		virtual int perform(int on) override { return on - _n; }
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::sub, _n }; }
 	private:
 		int _n;
 	};
@@ -312,23 +307,17 @@ namespace default_operation {
 	public:
 		explicit mul(int n) : _n(n) { }
 		virtual std::string get_string() const noexcept override { return "x" + util::as_string(_n); }
-		virtual int perform(int on) override { return on * _n; }
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::mul, _n }; }
 	private:
 		int _n;
 	};
 
-	// divide by N and throw an exception if that produced a float
+	// divide by N and fail if that produced a float
 	class divi : public numeric_operation {
 	public:
 		explicit divi(int n) : _n(n) { }
 		virtual std::string get_string() const noexcept override { return "/" + util::as_string(_n); }
-		virtual int perform(int on) override {
-			if (on % _n != 0)
-				throw operation_exception("floating point");
-
-			return on / _n;
-		}
-
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::divi, _n }; }
 	private:
 		int _n;
 	};
@@ -338,10 +327,7 @@ namespace default_operation {
 	public:
 		explicit mod(int n) : _n(n) { }
 		virtual std::string get_string() const noexcept override { return "%" + util::as_string(_n); }
-		virtual int perform(int on) override {
-			return on % _n;
-		}
-
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::mod, _n }; }
 	private:
 		int _n;
 	};
@@ -351,26 +337,12 @@ namespace default_operation {
 	// 0 ... 2 -> 2
 	// 42 ... 0 -> 420
 	// 1234 ... 5 -> 12345
+	// 1234 ... 56 -> 123456
 	class cat : public numeric_operation {
 	public:
 		explicit cat(int n) : _n(n) { }
 		virtual std::string get_string() const noexcept override { return ".." + util::as_string(_n); }
-		virtual int perform(int on) override {
-			int sign = (on < 0) ? -1 : 1;
-
-			on *= sign;
-
-			int _data_cpy = _n;
-			do {
-				on *= 10;
-				on += _n % 10;
-
-				_data_cpy /= 10;
-			} while (_data_cpy != 0);
-
-			return on * sign;
-		}
-
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::cat, _n }; }
 	private:
 		int _n;
 	};
@@ -381,10 +353,7 @@ namespace default_operation {
 	public :
 		explicit del() { }
 		virtual std::string get_string() const noexcept override { return "<<"; }
-		virtual int perform(int on) override {
-			return on / 10;
-		}
-
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::del, 0 }; }
 	private:
 		int _n;
 	};
@@ -394,9 +363,7 @@ namespace default_operation {
 	public:
 		explicit sign_invert() { }
 		virtual std::string get_string() const noexcept override { return "+/-"; }
-		virtual int perform(int on) override {
-			return on * -1;
-		}
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::sign_invert, 0 }; }
 	};
 
 	// |x|. take the absolute value of x
@@ -404,9 +371,7 @@ namespace default_operation {
 	public:
 		explicit sign_posative() { }
 		virtual std::string get_string() const noexcept override { return "|x|"; }
-		virtual int perform(int on) override {
-			return std::abs(on);
-		}
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::sign_posative, 0 }; }
 	};
 
 	// x^n. raise x to the nth power
@@ -414,13 +379,29 @@ namespace default_operation {
 	public :
 		explicit power(int n) : _n(n) { }
 		virtual std::string get_string() const noexcept override { return "x^" + util::as_string(_n); }
-		virtual int perform(int on) override {
-			return std::pow(on, _n);
-		}
-
+		virtual numeric::opcode to_opcode() const noexcept override { return { numeric::opcode::kind::power, _n }; }
 	private:
 		int _n;
 	};
+
+	// the inverse of numeric_operation::to_opcode()
+	// rebuild the class that an opcode was taken from
+	inline std::shared_ptr<numeric_operation> from_opcode(numeric::opcode op) {
+		switch (op.type) {
+			case numeric::opcode::kind::add: return std::make_shared<add>(op.n);
+			case numeric::opcode::kind::sub: return std::make_shared<sub>(op.n);
+			case numeric::opcode::kind::mul: return std::make_shared<mul>(op.n);
+			case numeric::opcode::kind::divi: return std::make_shared<divi>(op.n);
+			case numeric::opcode::kind::mod: return std::make_shared<mod>(op.n);
+			case numeric::opcode::kind::cat: return std::make_shared<cat>(op.n);
+			case numeric::opcode::kind::del: return std::make_shared<del>();
+			case numeric::opcode::kind::sign_invert: return std::make_shared<sign_invert>();
+			case numeric::opcode::kind::sign_posative: return std::make_shared<sign_posative>();
+			case numeric::opcode::kind::power: return std::make_shared<power>(op.n);
+		}
+
+		throw std::logic_error("invalid opcode");
+	}
 };
 
 #endif // !_OPERATION_HPP
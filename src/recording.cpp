@@ -0,0 +1,308 @@
+/*
+ * recording.cpp:
+ * implements the input recorder and player in recording.hpp
+ */
+
+#include "recording.hpp"
+
+#include <stdexcept>
+#include <iterator>
+#include <cstring>
+
+namespace {
+
+	// write the lowest bytes of value, least significant first
+	void put(std::string& out, std::uint32_t value, int bytes) {
+		for (int b = 0; b < bytes; b++)
+			out.push_back(static_cast<char>((value >> (8 * b)) & 0xff));
+	}
+
+	void put_float(std::string& out, float value) {
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		put(out, bits, 4);
+	}
+
+	// the reverse, returning false instead when too few bytes are left
+	bool get(const std::vector<char>& in, std::size_t& at, std::uint32_t& value, int bytes) {
+		if (in.size() - at < static_cast<std::size_t>(bytes))
+			return false;
+
+		value = 0;
+		for (int b = 0; b < bytes; b++)
+			value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[at++])) << (8 * b);
+
+		return true;
+	}
+
+	bool get_float(const std::vector<char>& in, std::size_t& at, float& value) {
+		std::uint32_t bits;
+		if (!get(in, at, bits, 4))
+			return false;
+
+		std::memcpy(&value, &bits, sizeof(value));
+		return true;
+	}
+
+	// window coordinates always fit in 16 bits
+	std::int32_t as_signed16(std::uint32_t value) {
+		return static_cast<std::int16_t>(static_cast<std::uint16_t>(value));
+	}
+};
+
+namespace recording {
+
+	recorder::recorder(const std::string& path)
+		: _out(path, std::ios::binary) {
+
+		if (!_out)
+			throw std::runtime_error("could not write recording: " + path);
+	}
+
+	recorder::~recorder() {
+		flush();
+	}
+
+	// the header goes before anything logged so far
+	void recorder::start(const sf::Vector2u& size) {
+		std::string header(magic, sizeof(magic));
+		put(header, size.x, 2);
+		put(header, size.y, 2);
+
+		_buffer.insert(0, header);
+	}
+
+	// only the members of the event's type are kept
+	void recorder::event(const sf::Event& e) {
+		put(_buffer, tag::first_event + static_cast<std::uint32_t>(e.type), 1);
+
+		// the payload size is filled in once written
+		std::size_t size_at = _buffer.size();
+		_buffer.push_back(0);
+
+		switch (e.type) {
+			case sf::Event::Resized:
+				put(_buffer, e.size.width, 2);
+				put(_buffer, e.size.height, 2);
+				break;
+			case sf::Event::TextEntered:
+				put(_buffer, e.text.unicode, 4);
+				break;
+			case sf::Event::KeyPressed:
+			case sf::Event::KeyReleased:
+				put(_buffer, static_cast<std::uint32_t>(e.key.code), 2);
+				put(_buffer, e.key.alt | (e.key.control << 1) | (e.key.shift << 2) | (e.key.system << 3), 1);
+				break;
+			case sf::Event::MouseWheelMoved:
+				put(_buffer, static_cast<std::uint32_t>(e.mouseWheel.delta), 2);
+				put(_buffer, static_cast<std::uint32_t>(e.mouseWheel.x), 2);
+				put(_buffer, static_cast<std::uint32_t>(e.mouseWheel.y), 2);
+				break;
+			case sf::Event::MouseWheelScrolled:
+				put(_buffer, static_cast<std::uint32_t>(e.mouseWheelScroll.wheel), 1);
+				put_float(_buffer, e.mouseWheelScroll.delta);
+				put(_buffer, static_cast<std::uint32_t>(e.mouseWheelScroll.x), 2);
+				put(_buffer, static_cast<std::uint32_t>(e.mouseWheelScroll.y), 2);
+				break;
+			case sf::Event::MouseButtonPressed:
+			case sf::Event::MouseButtonReleased:
+				put(_buffer, static_cast<std::uint32_t>(e.mouseButton.button), 1);
+				put(_buffer, static_cast<std::uint32_t>(e.mouseButton.x), 2);
+				put(_buffer, static_cast<std::uint32_t>(e.mouseButton.y), 2);
+				break;
+			case sf::Event::MouseMoved:
+				put(_buffer, static_cast<std::uint32_t>(e.mouseMove.x), 2);
+				put(_buffer, static_cast<std::uint32_t>(e.mouseMove.y), 2);
+				break;
+			case sf::Event::JoystickButtonPressed:
+			case sf::Event::JoystickButtonReleased:
+				put(_buffer, e.joystickButton.joystickId, 1);
+				put(_buffer, e.joystickButton.button, 1);
+				break;
+			case sf::Event::JoystickMoved:
+				put(_buffer, e.joystickMove.joystickId, 1);
+				put(_buffer, static_cast<std::uint32_t>(e.joystickMove.axis), 1);
+				put_float(_buffer, e.joystickMove.position);
+				break;
+			case sf::Event::JoystickConnected:
+			case sf::Event::JoystickDisconnected:
+				put(_buffer, e.joystickConnect.joystickId, 1);
+				break;
+			case sf::Event::TouchBegan:
+			case sf::Event::TouchMoved:
+			case sf::Event::TouchEnded:
+				put(_buffer, e.touch.finger, 1);
+				put(_buffer, static_cast<std::uint32_t>(e.touch.x), 2);
+				put(_buffer, static_cast<std::uint32_t>(e.touch.y), 2);
+				break;
+			case sf::Event::SensorChanged:
+				put(_buffer, static_cast<std::uint32_t>(e.sensor.type), 1);
+				put_float(_buffer, e.sensor.x);
+				put_float(_buffer, e.sensor.y);
+				put_float(_buffer, e.sensor.z);
+				break;
+			default:
+				break;
+		}
+
+		_buffer[size_at] = static_cast<char>(_buffer.size() - size_at - 1);
+	}
+
+	void recorder::note(const recording::note& n) {
+		unsigned char payload[note_size];
+		encode(n, payload);
+
+		put(_buffer, tag::note, 1);
+		put(_buffer, note_size, 1);
+		_buffer.append(reinterpret_cast<const char*>(payload), note_size);
+	}
+
+	// one write per frame, rather than per event
+	void recorder::frame(float dt) {
+		put(_buffer, tag::frame, 1);
+		put(_buffer, 4, 1);
+		put_float(_buffer, dt);
+
+		flush();
+	}
+
+	void recorder::flush() {
+		if (_buffer.empty())
+			return;
+
+		_out.write(_buffer.data(), _buffer.size());
+		_out.flush();
+		_buffer.clear();
+	}
+
+	player::player(const std::string& path) : _at(header_size) {
+		std::ifstream in(path, std::ios::binary);
+
+		if (!in)
+			throw std::runtime_error("could not read recording: " + path);
+
+		_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+		std::size_t at = 4;
+		std::uint32_t width, height;
+
+		if (_data.size() < header_size || std::memcmp(_data.data(), magic, sizeof(magic)) != 0 || !get(_data, at, width, 2) || !get(_data, at, height, 2))
+			throw std::runtime_error("not a recording: " + path);
+
+		_size = sf::Vector2u(width, height);
+	}
+
+	sf::Vector2u player::size() const noexcept {
+		return _size;
+	}
+
+	// the reverse of recorder::event() and recorder::frame()
+	player::kind player::next(sf::Event& e, float& dt) {
+		std::uint32_t type, size, a = 0, b = 0, c = 0;
+
+		// skip notes and anything else that isn't a frame or an event
+		for (;;) {
+			if (!get(_data, _at, type, 1) || !get(_data, _at, size, 1) || _data.size() - _at < size)
+				return kind::end;
+
+			if (type == tag::frame || (type >= tag::first_event && type - tag::first_event < static_cast<std::uint32_t>(sf::Event::Count)))
+				break;
+
+			_at += size;
+		}
+
+		std::size_t stop = _at + size;
+
+		if (type == tag::frame) {
+			bool ok = get_float(_data, _at, dt) && _at <= stop;
+			_at = stop;
+
+			return ok ? kind::frame : kind::end;
+		}
+
+		e = sf::Event();
+		e.type = static_cast<sf::Event::EventType>(type - tag::first_event);
+		bool ok = true;
+
+		switch (e.type) {
+			case sf::Event::Resized:
+				ok = get(_data, _at, a, 2) && get(_data, _at, b, 2);
+				e.size.width = a;
+				e.size.height = b;
+				break;
+			case sf::Event::TextEntered:
+				ok = get(_data, _at, a, 4);
+				e.text.unicode = a;
+				break;
+			case sf::Event::KeyPressed:
+			case sf::Event::KeyReleased:
+				ok = get(_data, _at, a, 2) && get(_data, _at, b, 1);
+				e.key.code = static_cast<sf::Keyboard::Key>(as_signed16(a));
+				e.key.alt = b & 1;
+				e.key.control = (b >> 1) & 1;
+				e.key.shift = (b >> 2) & 1;
+				e.key.system = (b >> 3) & 1;
+				break;
+			case sf::Event::MouseWheelMoved:
+				ok = get(_data, _at, a, 2) && get(_data, _at, b, 2) && get(_data, _at, c, 2);
+				e.mouseWheel.delta = as_signed16(a);
+				e.mouseWheel.x = as_signed16(b);
+				e.mouseWheel.y = as_signed16(c);
+				break;
+			case sf::Event::MouseWheelScrolled:
+				ok = get(_data, _at, a, 1) && get_float(_data, _at, e.mouseWheelScroll.delta) && get(_data, _at, b, 2) && get(_data, _at, c, 2);
+				e.mouseWheelScroll.wheel = static_cast<sf::Mouse::Wheel>(a);
+				e.mouseWheelScroll.x = as_signed16(b);
+				e.mouseWheelScroll.y = as_signed16(c);
+				break;
+			case sf::Event::MouseButtonPressed:
+			case sf::Event::MouseButtonReleased:
+				ok = get(_data, _at, a, 1) && get(_data, _at, b, 2) && get(_data, _at, c, 2);
+				e.mouseButton.button = static_cast<sf::Mouse::Button>(a);
+				e.mouseButton.x = as_signed16(b);
+				e.mouseButton.y = as_signed16(c);
+				break;
+			case sf::Event::MouseMoved:
+				ok = get(_data, _at, a, 2) && get(_data, _at, b, 2);
+				e.mouseMove.x = as_signed16(a);
+				e.mouseMove.y = as_signed16(b);
+				break;
+			case sf::Event::JoystickButtonPressed:
+			case sf::Event::JoystickButtonReleased:
+				ok = get(_data, _at, a, 1) && get(_data, _at, b, 1);
+				e.joystickButton.joystickId = a;
+				e.joystickButton.button = b;
+				break;
+			case sf::Event::JoystickMoved:
+				ok = get(_data, _at, a, 1) && get(_data, _at, b, 1) && get_float(_data, _at, e.joystickMove.position);
+				e.joystickMove.joystickId = a;
+				e.joystickMove.axis = static_cast<sf::Joystick::Axis>(b);
+				break;
+			case sf::Event::JoystickConnected:
+			case sf::Event::JoystickDisconnected:
+				ok = get(_data, _at, a, 1);
+				e.joystickConnect.joystickId = a;
+				break;
+			case sf::Event::TouchBegan:
+			case sf::Event::TouchMoved:
+			case sf::Event::TouchEnded:
+				ok = get(_data, _at, a, 1) && get(_data, _at, b, 2) && get(_data, _at, c, 2);
+				e.touch.finger = a;
+				e.touch.x = as_signed16(b);
+				e.touch.y = as_signed16(c);
+				break;
+			case sf::Event::SensorChanged:
+				ok = get(_data, _at, a, 1) && get_float(_data, _at, e.sensor.x) && get_float(_data, _at, e.sensor.y) && get_float(_data, _at, e.sensor.z);
+				e.sensor.type = static_cast<sf::Sensor::Type>(a);
+				break;
+			default:
+				break;
+		}
+
+		// a payload shorter than its type needs is as bad as a truncated one
+		ok = ok && _at <= stop;
+		_at = stop;
+
+		return ok ? kind::event : kind::end;
+	}
+};
@@ -0,0 +1,84 @@
+/*
+ * recording.hpp:
+ * a compact binary log of every sf::Event dispatched by core::run and the dt of every frame
+ * so a game can be replayed exactly, without a window and as fast as it will go (see core::replay)
+ * the format is in recording_format.hpp
+ */
+
+#ifndef _RECORDING_HPP
+#define _RECORDING_HPP
+
+#include <SFML/Window.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "recording_format.hpp"
+
+namespace recording {
+
+	// write a recording as the game is played
+	class recorder {
+	public:
+
+		// start a recording in path
+		// throws std::runtime_error when the file can't be written
+		explicit recorder(const std::string& path);
+
+		// writes out whatever is still buffered
+		~recorder();
+
+		// the size of the window being recorded, given once it exists and before the first frame
+		void start(const sf::Vector2u& size);
+
+		// log an event before it is dispatched
+		void event(const sf::Event& e);
+
+		// log what the game did, see recording::note
+		void note(const recording::note& n);
+
+		// log the end of a frame and the dt passed to its update, then flush()
+		void frame(float dt);
+
+		// write out every record logged so far
+		// core::run calls this every frame, whether or not it updated, and before the game exits
+		void flush();
+
+	private:
+		std::ofstream _out;
+		std::string _buffer; // records not yet written, see flush()
+	};
+
+	// read a recording back
+	class player {
+	public:
+
+		// what next() found
+		enum class kind {
+			event,
+			frame,
+			end
+		};
+
+		// load the recording in path
+		// throws std::runtime_error when the file can't be read or isn't a recording
+		explicit player(const std::string& path);
+
+		// the size of the window that was recorded
+		sf::Vector2u size() const noexcept;
+
+		// the next record, filling e for an event and dt for a frame
+		// notes are skipped as replaying the events makes them again
+		// a truncated record reads as the end
+		kind next(sf::Event& e, float& dt);
+
+	private:
+		std::vector<char> _data;
+		std::size_t _at;
+		sf::Vector2u _size;
+	};
+};
+
+#endif // !_RECORDING_HPP
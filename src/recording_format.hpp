@@ -0,0 +1,70 @@
+/*
+ * recording_format.hpp:
+ * the framing of a recording (see recording.hpp) without SFML, so the headless tools can read one
+ * the log is little endian:
+ * "CRL2", uint16 window width, uint16 window height
+ * then records, each a uint8 tag, a uint8 payload size and the payload:
+ * tag 0: the end of a frame, float32 dt
+ * tag 1: a note, what a press or level change did to the game (see note below)
+ * tag 2 + sf::Event::EventType: an event, with only the members of its type, see recording.cpp
+ * the size lets a reader skip any record it doesn't understand
+ */
+
+#ifndef _RECORDING_FORMAT_HPP
+#define _RECORDING_FORMAT_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace recording {
+
+	const char magic[4] = { 'C', 'R', 'L', '2' };
+
+	// bytes before the first record, and before the payload of every record
+	const std::size_t header_size = 8;
+	const std::size_t record_header = 2;
+
+	namespace tag {
+		const std::uint8_t frame = 0;
+		const std::uint8_t note = 1;
+		const std::uint8_t first_event = 2; // + sf::Event::EventType
+	};
+
+	// what the game did in response to input, logged alongside the input itself
+	// lets a recording be analysed without replaying it through the game
+	// payload: uint8 what, uint16 level, uint8 button, uint8 verdict
+	struct note {
+		enum class kind : std::uint8_t {
+			start, // level started, from level::run()
+			reset, // the AC button, followed by the start of the same level
+			press // button of level pressed, leaving it in verdict
+		};
+
+		kind what;
+		std::uint16_t level;
+		std::uint8_t button; // for a press, the index into game::level::operations
+		std::uint8_t verdict; // for a press, a game::verdict
+	};
+
+	const std::size_t note_size = 5;
+
+	inline void encode(const note& n, unsigned char* out) {
+		out[0] = static_cast<unsigned char>(n.what);
+		out[1] = n.level & 0xff;
+		out[2] = n.level >> 8;
+		out[3] = n.button;
+		out[4] = n.verdict;
+	}
+
+	inline note decode(const unsigned char* in) {
+		note n;
+		n.what = static_cast<note::kind>(in[0]);
+		n.level = static_cast<std::uint16_t>(in[1] | (in[2] << 8));
+		n.button = in[3];
+		n.verdict = in[4];
+
+		return n;
+	}
+};
+
+#endif // !_RECORDING_FORMAT_HPP
@@ -0,0 +1,89 @@
+/*
+ * ring.hpp:
+ * a first in first out queue in one circular buffer, doubled when full
+ * unlike std::deque it needs no allocation once it has grown to its busiest
+ * and holds types that can't be assigned, e.g. events with const members
+ */
+
+#ifndef _RING_HPP
+#define _RING_HPP
+
+#include <type_traits>
+#include <utility>
+#include <memory>
+#include <new>
+
+namespace util {
+
+	template <typename T>
+	class ring {
+	public:
+		ring() : _capacity(0), _head(0), _size(0) { }
+
+		ring(const ring&)=delete;
+		ring& operator=(const ring&)=delete;
+
+		~ring() {
+			clear();
+		}
+
+		std::size_t size() const noexcept { return _size; }
+		bool empty() const noexcept { return _size == 0; }
+
+		T& front() { return _at(0); }
+		T& back() { return _at(_size - 1); }
+
+		void push_back(const T& t) {
+			if (_size == _capacity)
+				_grow();
+
+			new (&_at(_size)) T(t);
+			_size++;
+		}
+
+		void pop_front() {
+			_at(0).~T();
+			_head = (_head + 1) & (_capacity - 1);
+			_size--;
+		}
+
+		// replace the last element, for types that can't be assigned
+		void replace_back(const T& t) {
+			T* p = &back();
+			p->~T();
+			new (p) T(t);
+		}
+
+		void clear() {
+			while (_size > 0)
+				pop_front();
+		}
+
+	private:
+		typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot;
+
+		// the i-th element from the front, capacity is always a power of two
+		T& _at(std::size_t i) {
+			return *reinterpret_cast<T*>(&_slots[(_head + i) & (_capacity - 1)]);
+		}
+
+		void _grow() {
+			std::size_t capacity = _capacity ? 2 * _capacity : 16;
+			std::unique_ptr<slot[]> slots(new slot[capacity]);
+
+			for (std::size_t i = 0; i < _size; i++) {
+				new (&slots[i]) T(std::move(_at(i)));
+				_at(i).~T();
+			}
+
+			_slots = std::move(slots);
+			_capacity = capacity;
+			_head = 0;
+		}
+
+		std::unique_ptr<slot[]> _slots;
+		std::size_t _capacity, _head, _size;
+	};
+};
+
+#endif // !_RING_HPP
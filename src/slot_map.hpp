@@ -0,0 +1,155 @@
+/*
+ * slot_map.hpp:
+ * values kept contiguous in a dense vector, addressed by handles that stay valid while others come and go
+ * insert and erase are O(1) and visiting every value is a linear scan
+ * a handle names a slot and the generation of the slot it was given out for,
+ * so the handle of an erased value never finds whatever reuses its slot
+ */
+
+#ifndef _SLOT_MAP_HPP
+#define _SLOT_MAP_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+	template <typename V>
+	class slot_map {
+	public:
+		struct handle {
+			std::uint32_t index, generation;
+		};
+
+		slot_map() : _visiting(0), _dead(0) { }
+
+		// store v, returning the handle to erase it with
+		// a value inserted while visiting is only visited by the next for_each()
+		handle insert(V v) {
+			std::uint32_t s;
+
+			if (_free.empty()) {
+				s = static_cast<std::uint32_t>(_slots.size());
+				_slots.push_back({ 0, 0 });
+			} else {
+				s = _free.back();
+				_free.pop_back();
+			}
+
+			if (_visiting > 0) {
+				_slots[s].dense = pending;
+				_incoming.emplace_back(s, std::move(v));
+			} else {
+				_slots[s].dense = static_cast<std::uint32_t>(_values.size());
+				_values.push_back(std::move(v));
+				_owners.push_back(s);
+			}
+
+			return handle { s, _slots[s].generation };
+		}
+
+		// remove the value of h, returns false if it was already gone
+		// a value erased while visiting is skipped from then on and removed once the visit ends
+		bool erase(handle h) {
+			if (!contains(h))
+				return false;
+
+			auto& slot = _slots[h.index];
+
+			if (slot.dense == pending) {
+				for (auto it = _incoming.begin(); it != _incoming.end(); it++)
+					if (it->first == h.index) { _incoming.erase(it); break; }
+			}
+			else if (_visiting > 0) {
+				_owners[slot.dense] = dead;
+				_dead++;
+			}
+			else _remove(slot.dense);
+
+			slot.generation++;
+			_free.push_back(h.index);
+
+			return true;
+		}
+
+		bool contains(handle h) const noexcept {
+			return h.index < _slots.size() && _slots[h.index].generation == h.generation;
+		}
+
+		std::size_t size() const noexcept {
+			return _values.size() - _dead + _incoming.size();
+		}
+
+		// call f on every value, in no particular order
+		// f may insert and erase (even the value it was called on), see above
+		template <typename F>
+		void for_each(F&& f) {
+			_visiting++;
+
+			// nothing moves until the visit ends, so the arrays are only looked up once
+			V* values = _values.data();
+			const std::uint32_t* owners = _owners.data();
+
+			for (std::size_t d = 0, end = _values.size(); d < end; d++) {
+				if (owners[d] != dead)
+					f(values[d]);
+			}
+
+			if (--_visiting == 0 && (_dead > 0 || !_incoming.empty()))
+				_settle();
+		}
+
+	private:
+		struct slot {
+			std::uint32_t dense; // index into _values, or pending
+			std::uint32_t generation;
+		};
+
+		static const std::uint32_t pending = 0xffffffff;
+		static const std::uint32_t dead = 0xffffffff;
+
+		// move the last value into d
+		void _remove(std::uint32_t d) {
+			std::uint32_t last = static_cast<std::uint32_t>(_values.size() - 1);
+
+			if (d != last) {
+				_values[d] = std::move(_values[last]);
+				_owners[d] = _owners[last];
+
+				if (_owners[d] != dead)
+					_slots[_owners[d]].dense = d;
+			}
+
+			_values.pop_back();
+			_owners.pop_back();
+		}
+
+		// apply what was deferred by a visit
+		void _settle() {
+			for (std::size_t d = _values.size(); d-- > 0;) {
+				if (_owners[d] == dead)
+					_remove(static_cast<std::uint32_t>(d));
+			}
+
+			for (auto& p : _incoming) {
+				_slots[p.first].dense = static_cast<std::uint32_t>(_values.size());
+				_values.push_back(std::move(p.second));
+				_owners.push_back(p.first);
+			}
+
+			_dead = 0;
+			_incoming.clear();
+		}
+
+		std::vector<V> _values;
+		std::vector<std::uint32_t> _owners; // the slot of each value, or dead
+		std::vector<slot> _slots;
+		std::vector<std::uint32_t> _free;
+		std::vector<std::pair<std::uint32_t, V>> _incoming; // inserted while visiting
+		int _visiting;
+		std::size_t _dead;
+	};
+};
+
+#endif // !_SLOT_MAP_HPP
@@ -11,6 +11,8 @@
 #include <iostream>
 #include <cmath>
 
+#include "batch.hpp"
+
 using text_align_t=int;
 
 // bit values for text alignment
@@ -103,6 +105,8 @@ public:
 		// finally update origin/position based on calculated values
 		_text.setOrigin(local.left, local.top);
 		_text.setPosition(x, y);
+
+		render_batch::changed();
 	}
 
 	// update alignment box
@@ -130,6 +134,8 @@ public:
 	// update text fill colour
 	void set_colour(const sf::Color& col) {
 		_text.setFillColor(col);
+
+		render_batch::changed();
 	}
 
 	// modify the alignment value and hence recalculate alignment
@@ -174,6 +180,11 @@ public:
 #endif
 	};
 
+	// add the text to a batch, to be drawn with everything else in it
+	virtual void batch(render_batch& b) const {
+		b.add(_text);
+	}
+
 	// return current text
 	std::string get_string() const {
 		return _text.getString();
@@ -0,0 +1,204 @@
+/*
+ * trace.cpp:
+ * implements the event instrumentation in trace.hpp
+ */
+
+#include "trace.hpp"
+
+#if defined(CALCULATOR_EVENT_TRACE)
+
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <memory>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
+namespace {
+
+	// spans kept by a capture, after which it stops growing
+	const std::size_t max_spans = 1 << 22;
+
+	struct captured {
+		const std::string* name;
+		event::trace::span::kind kind;
+		std::int64_t start, ns; // since the capture started
+	};
+
+	std::unique_ptr<std::ofstream> _out;
+	std::vector<captured> _spans;
+	std::chrono::steady_clock::time_point _epoch;
+
+	// a readable name of t, e.g. posts::display_event<(posts::display_event_mode)0>
+	std::string demangle(const std::type_info& t) {
+#if defined(__GNUC__)
+		int status = 0;
+		char* name = abi::__cxa_demangle(t.name(), nullptr, nullptr, &status);
+
+		if (status == 0 && name) {
+			std::string ret = name;
+			std::free(name);
+			return ret;
+		}
+#endif
+		return t.name();
+	}
+
+	// demangled once per type, the strings never move so captured spans point at them
+	const std::string& name_of(const std::type_info& t) {
+		static std::unordered_map<const std::type_info*, std::unique_ptr<std::string>> names;
+
+		auto& n = names[&t];
+		if (!n)
+			n.reset(new std::string(demangle(t)));
+
+		return *n;
+	}
+
+	// e.g. lambda_listener<sf_event::MouseMoved>, as lambdas have no name of their own
+	const std::string& lambda_name(const event::trace::counters& c) {
+		static std::unordered_map<const event::trace::counters*, std::unique_ptr<std::string>> names;
+
+		auto& n = names[&c];
+		if (!n)
+			n.reset(new std::string("lambda_listener<" + c.type + ">"));
+
+		return *n;
+	}
+
+	const std::string& drain_name() {
+		static const std::string name = "event::drain";
+		return name;
+	}
+
+	// s quoted for json, type names hold no control characters so only quotes and backslashes are escaped
+	std::string json_string(const std::string& s) {
+		std::string ret = "\"";
+
+		for (auto c : s) {
+			if (c == '"' || c == '\\')
+				ret += '\\';
+
+			ret += c;
+		}
+
+		return ret + "\"";
+	}
+};
+
+namespace event {
+	namespace trace {
+
+		counters::counters(const std::type_info& t)
+			: type(demangle(t)), posts(0), calls(0), ns(0) {
+			std::fill(std::begin(buckets), std::end(buckets), 0);
+		}
+
+		std::uint64_t counters::quantile(double q) const {
+			std::uint64_t rank = static_cast<std::uint64_t>(q * calls) + 1, seen = 0;
+
+			for (int b = 0; b < 40; b++) {
+				seen += buckets[b];
+
+				if (seen >= rank)
+					return std::uint64_t(1) << (b + 1);
+			}
+
+			return 0;
+		}
+
+		std::vector<counters*>& all() {
+			static std::vector<counters*> every;
+			return every;
+		}
+
+		span::span(kind k, counters* c, const std::type_info* listener)
+			: _kind(k), _counters(c), _listener(listener), _start(std::chrono::steady_clock::now()) {
+		}
+
+		// counted always, captured only while capture() is on
+		span::~span() {
+			auto end = std::chrono::steady_clock::now();
+			std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - _start).count();
+
+			if (_kind == kind::post)
+				_counters->posts++;
+			else if (_kind == kind::listener) {
+				_counters->calls++;
+				_counters->ns += ns;
+
+				int b = 0;
+				while (b < 39 && (std::int64_t(1) << (b + 1)) <= ns)
+					b++;
+
+				_counters->buckets[b]++;
+			}
+
+			if (!_out || _spans.size() >= max_spans)
+				return;
+
+			const std::string* name = &drain_name();
+
+			if (_kind == kind::post)
+				name = &_counters->type;
+			else if (_kind == kind::listener)
+				name = _listener ? &name_of(*_listener) : &lambda_name(*_counters);
+
+			auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(_start - _epoch).count();
+			_spans.push_back(captured { name, _kind, start, ns });
+		}
+
+		bool capture(const std::string& path) {
+			_out.reset(new std::ofstream(path));
+
+			if (!*_out) {
+				_out.reset();
+				return false;
+			}
+
+			_epoch = std::chrono::steady_clock::now();
+			std::atexit(finish);
+
+			return true;
+		}
+
+		// complete ("X") events in microseconds, nested by the viewer from their times
+		void finish() {
+			if (!_out)
+				return;
+
+			auto& out = *_out;
+			out << "{\"traceEvents\":[\n";
+
+			for (std::size_t i = 0; i < _spans.size(); i++) {
+				const auto& s = _spans[i];
+				const char* category = (s.kind == span::kind::post) ? "post" : (s.kind == span::kind::listener) ? "listener" : "drain";
+
+				out << (i == 0 ? "" : ",\n") << "{\"name\":" << json_string(*s.name) << ",\"cat\":\"" << category << "\",\"ph\":\"X\""
+					<< ",\"ts\":" << std::fixed << std::setprecision(3) << s.start / 1000.0 << ",\"dur\":" << s.ns / 1000.0
+					<< ",\"pid\":1,\"tid\":1}";
+			}
+
+			out << "\n]}\n";
+			_out.reset();
+			_spans.clear();
+		}
+
+		void report(std::ostream& out) {
+			out << std::setw(12) << "posts" << std::setw(12) << "calls" << std::setw(12) << "total us"
+				<< std::setw(12) << "p50 ns" << std::setw(12) << "p99 ns" << "  type" << std::endl;
+
+			for (auto c : all()) {
+				out << std::setw(12) << c->posts << std::setw(12) << c->calls << std::setw(12) << c->ns / 1000
+					<< std::setw(12) << c->quantile(0.5) << std::setw(12) << c->quantile(0.99) << "  " << c->type << std::endl;
+			}
+		}
+	};
+};
+
+#endif // CALCULATOR_EVENT_TRACE
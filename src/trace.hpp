@@ -0,0 +1,89 @@
+/*
+ * trace.hpp:
+ * instrumentation of event::dispatch, compiled in only with CALCULATOR_EVENT_TRACE (cmake -DCALCULATOR_EVENT_TRACE=ON)
+ * counts the posts of every event type and times every listener they reach,
+ * and can capture every post, listener and drain as a chrome trace (chrome://tracing or ui.perfetto.dev)
+ * nested as they happened, e.g. a click -> numeric_operation::call -> display events -> game_renderer::listen
+ * without the define none of this exists and dispatch.hpp is untouched
+ */
+
+#ifndef _TRACE_HPP
+#define _TRACE_HPP
+
+#if defined(CALCULATOR_EVENT_TRACE)
+
+#include <typeinfo>
+#include <cstdint>
+#include <ostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace event {
+	namespace trace {
+
+		// what has happened to one event type
+		struct counters {
+			std::string type;
+			std::uint64_t posts, calls; // listener calls
+			std::uint64_t ns; // spent in listeners
+			std::uint64_t buckets[40]; // listener calls taking [2^b, 2^(b+1)) ns
+
+			explicit counters(const std::type_info& t);
+
+			// the upper bound in ns of the q-th quantile of listener calls, 0 when there were none
+			std::uint64_t quantile(double q) const;
+		};
+
+		// every type counted so far
+		std::vector<counters*>& all();
+
+		// the counters of T, made on first use
+		template <typename T>
+		counters& of() {
+			static counters c(typeid(T));
+			static bool registered = (all().push_back(&c), true);
+			(void)registered;
+
+			return c;
+		}
+
+		// a timed region, counted and captured when it ends
+		class span {
+		public:
+			enum class kind {
+				post,
+				listener,
+				drain
+			};
+
+			// what names the region in a trace: the counters' type, or for a listener its dynamic type
+			// listener is null for a lambda_listener, counters is null for a drain
+			span(kind k, counters* c, const std::type_info* listener=nullptr);
+			~span();
+
+			span(const span&)=delete;
+			span& operator=(const span&)=delete;
+
+		private:
+			kind _kind;
+			counters* _counters;
+			const std::type_info* _listener;
+			std::chrono::steady_clock::time_point _start;
+		};
+
+		// capture every span from now on to path, written out by finish() (or at exit)
+		// returns false when path can't be written
+		bool capture(const std::string& path);
+
+		// write out the capture, if any
+		void finish();
+
+		// a table of every type: posts, listener calls and listener time with its p50 and p99
+		void report(std::ostream& out);
+	};
+};
+
+#endif // CALCULATOR_EVENT_TRACE
+
+#endif // !_TRACE_HPP
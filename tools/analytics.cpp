@@ -0,0 +1,296 @@
+/*
+ * analytics.cpp:
+ * implements the recording aggregates in analytics.hpp
+ */
+
+#include "analytics.hpp"
+#include "recording_format.hpp"
+#include "game.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cmath>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	// the shortest duration told apart and the ratio between neighbouring buckets
+	const double min_seconds = 0.01;
+	const double growth = 1.05;
+
+	// a float32 stored little endian
+	float get_float(const unsigned char* in) {
+		std::uint32_t bits = in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<std::uint32_t>(in[3]) << 24);
+
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+
+	double ratio(std::uint64_t a, std::uint64_t b) {
+		return b == 0 ? 0.0 : static_cast<double>(a) / b;
+	}
+};
+
+namespace analytics {
+
+	histogram::histogram() {
+		_counts.fill(0);
+	}
+
+	void histogram::add(double seconds) {
+		double b = (seconds > min_seconds) ? std::floor(std::log(seconds / min_seconds) / std::log(growth)) : 0.0;
+		_counts[static_cast<std::size_t>(std::min<double>(b, buckets - 1))]++;
+	}
+
+	void histogram::merge(const histogram& h) {
+		for (std::size_t b = 0; b < buckets; b++)
+			_counts[b] += h._counts[b];
+	}
+
+	std::uint64_t histogram::total() const noexcept {
+		std::uint64_t t = 0;
+		for (auto c : _counts)
+			t += c;
+
+		return t;
+	}
+
+	// the geometric middle of the bucket holding the q-th duration
+	double histogram::quantile(double q) const {
+		std::uint64_t t = total();
+		if (t == 0)
+			return -1.0;
+
+		std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * t)));
+
+		std::size_t b = 0;
+		for (std::uint64_t seen = _counts[0]; seen < rank; seen += _counts[++b]);
+
+		return min_seconds * std::pow(growth, b + 0.5);
+	}
+
+	level_stats::level_stats(std::size_t operations)
+		: attempts(0), resets(0), presses(0), wins(0), loses(0), errs(0), buttons(operations, 0) {
+	}
+
+	void level_stats::merge(const level_stats& s) {
+		attempts += s.attempts;
+		resets += s.resets;
+		presses += s.presses;
+		wins += s.wins;
+		loses += s.loses;
+		errs += s.errs;
+
+		for (std::size_t b = 0; b < buttons.size(); b++)
+			buttons[b] += s.buttons[b];
+
+		win_seconds.merge(s.win_seconds);
+	}
+
+	table::table() : recordings(0), bad(0), bytes(0), unknown(0) {
+		for (const auto& l : game::levels())
+			levels.emplace_back(l.operations.size());
+	}
+
+	// a single pass over the records, skipping events by their size
+	bool table::add(const unsigned char* data, std::size_t size) {
+		bytes += size;
+
+		if (size < recording::header_size || std::memcmp(data, recording::magic, sizeof(recording::magic)) != 0) {
+			bad++;
+			return false;
+		}
+
+		// the attempt being timed, until it is won or another starts
+		level_stats* playing = nullptr;
+		double elapsed = 0.0;
+
+		std::size_t at = recording::header_size;
+
+		while (size - at >= recording::record_header) {
+			std::uint8_t tag = data[at], length = data[at + 1];
+			at += recording::record_header;
+
+			if (size - at < length)
+				break;
+
+			const unsigned char* payload = data + at;
+			at += length;
+
+			if (tag == recording::tag::frame && length >= 4)
+				elapsed += get_float(payload);
+
+			if (tag != recording::tag::note || length < recording::note_size)
+				continue;
+
+			auto n = recording::decode(payload);
+
+			if (n.level >= levels.size()) {
+				unknown++;
+				continue;
+			}
+
+			auto& s = levels[n.level];
+
+			switch (n.what) {
+				case recording::note::kind::start:
+					s.attempts++;
+					playing = &s;
+					elapsed = 0.0;
+					break;
+				case recording::note::kind::reset:
+					s.resets++;
+					break;
+				case recording::note::kind::press:
+					if (n.button >= s.buttons.size()) {
+						unknown++;
+						break;
+					}
+
+					s.presses++;
+					s.buttons[n.button]++;
+
+					if (n.verdict == static_cast<std::uint8_t>(game::verdict::win)) {
+						s.wins++;
+
+						if (playing == &s)
+							s.win_seconds.add(elapsed);
+
+						playing = nullptr;
+					}
+					else if (n.verdict == static_cast<std::uint8_t>(game::verdict::lose))
+						s.loses++;
+					else if (n.verdict == static_cast<std::uint8_t>(game::verdict::err))
+						s.errs++;
+					break;
+				default:
+					unknown++;
+			}
+		}
+
+		// anything left over is a truncated record
+		if (at != size) {
+			bad++;
+			return false;
+		}
+
+		recordings++;
+		return true;
+	}
+
+	// mapped rather than read, so the kernel streams the file in and drops it again behind us
+	bool table::add_file(const std::string& path) {
+#if defined(_WIN32)
+		std::ifstream in(path, std::ios::binary);
+		if (!in) {
+			bad++;
+			return false;
+		}
+
+		std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		return add(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			bad++;
+			return false;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0) {
+			::close(fd);
+			bad++;
+			return false;
+		}
+
+		std::size_t size = static_cast<std::size_t>(st.st_size);
+		void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+
+		if (map == MAP_FAILED) {
+			bad++;
+			return false;
+		}
+
+		madvise(map, size, MADV_SEQUENTIAL);
+
+		bool ok = add(static_cast<const unsigned char*>(map), size);
+		munmap(map, size);
+
+		return ok;
+#endif
+	}
+
+	void table::merge(const table& t) {
+		for (std::size_t l = 0; l < levels.size(); l++)
+			levels[l].merge(t.levels[l]);
+
+		recordings += t.recordings;
+		bad += t.bad;
+		bytes += t.bytes;
+		unknown += t.unknown;
+	}
+
+	// rates are per attempt, times in seconds and buttons as 'op=presses' e.g. "+1=120 x2=40"
+	void table::write_csv(std::ostream& out) const {
+		out << "level,attempts,resets,presses,wins,loses,errs,win_rate,lose_rate,err_rate,median_win_seconds,p90_win_seconds,buttons\n";
+
+		for (std::size_t l = 0; l < levels.size(); l++) {
+			const auto& s = levels[l];
+			if (s.attempts == 0 && s.presses == 0)
+				continue;
+
+			out << l << "," << s.attempts << "," << s.resets << "," << s.presses << ","
+				<< s.wins << "," << s.loses << "," << s.errs << ","
+				<< ratio(s.wins, s.attempts) << "," << ratio(s.loses, s.attempts) << "," << ratio(s.errs, s.attempts) << ",";
+
+			if (s.win_seconds.total() != 0)
+				out << s.win_seconds.quantile(0.5) << "," << s.win_seconds.quantile(0.9) << ",";
+			else
+				out << ",,";
+
+			const auto& ops = game::levels()[l].operations;
+			for (std::size_t b = 0; b < ops.size(); b++)
+				out << (b == 0 ? "" : " ") << ops[b].get_string() << "=" << s.buttons[b];
+
+			out << "\n";
+		}
+	}
+
+	// the same as write_csv() with null for a level never won and buttons as an object
+	void table::write_json(std::ostream& out) const {
+		for (std::size_t l = 0; l < levels.size(); l++) {
+			const auto& s = levels[l];
+			if (s.attempts == 0 && s.presses == 0)
+				continue;
+
+			out << "{\"level\":" << l << ",\"attempts\":" << s.attempts << ",\"resets\":" << s.resets
+				<< ",\"presses\":" << s.presses << ",\"wins\":" << s.wins << ",\"loses\":" << s.loses << ",\"errs\":" << s.errs
+				<< ",\"win_rate\":" << ratio(s.wins, s.attempts) << ",\"lose_rate\":" << ratio(s.loses, s.attempts)
+				<< ",\"err_rate\":" << ratio(s.errs, s.attempts);
+
+			if (s.win_seconds.total() != 0)
+				out << ",\"median_win_seconds\":" << s.win_seconds.quantile(0.5) << ",\"p90_win_seconds\":" << s.win_seconds.quantile(0.9);
+			else
+				out << ",\"median_win_seconds\":null,\"p90_win_seconds\":null";
+
+			out << ",\"buttons\":{";
+
+			const auto& ops = game::levels()[l].operations;
+			for (std::size_t b = 0; b < ops.size(); b++)
+				out << (b == 0 ? "" : ",") << "\"" << ops[b].get_string() << "\":" << s.buttons[b];
+
+			out << "}}\n";
+		}
+	}
+};
@@ -0,0 +1,78 @@
+/*
+ * analytics.hpp:
+ * per-level aggregates over recorded games (see recording_format.hpp)
+ * built from the notes a recording keeps of what the game did, so nothing is replayed
+ * and a table takes the same memory however many recordings are folded into it
+ */
+
+#ifndef _ANALYTICS_HPP
+#define _ANALYTICS_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <array>
+
+namespace analytics {
+
+	// counts of durations in log spaced buckets, for quantiles in constant memory
+	// bucket b holds [min_seconds * growth^b, min_seconds * growth^(b+1)), the first and last take anything beyond
+	// so a quantile is within growth (5%) of the exact value
+	class histogram {
+	public:
+		static const std::size_t buckets = 256;
+
+		histogram();
+
+		void add(double seconds);
+		void merge(const histogram& h);
+
+		std::uint64_t total() const noexcept;
+
+		// the q-th quantile in seconds e.g. 0.5 for the median, or -1 when empty
+		double quantile(double q) const;
+
+	private:
+		std::array<std::uint64_t, buckets> _counts;
+	};
+
+	// everything played on one level of game::levels()
+	struct level_stats {
+		std::uint64_t attempts; // level starts, including after a reset
+		std::uint64_t resets; // AC presses
+		std::uint64_t presses, wins, loses, errs;
+		std::vector<std::uint64_t> buttons; // presses of each of the level's operations
+		histogram win_seconds; // from the start of an attempt to its win
+
+		explicit level_stats(std::size_t operations=0);
+
+		void merge(const level_stats& s);
+	};
+
+	// aggregates of every recording added, one row per level of game::levels()
+	class table {
+	public:
+		table();
+
+		// fold one recording in memory into the table
+		// returns false when it isn't a recording or is truncated, keeping whatever came before
+		bool add(const unsigned char* data, std::size_t size);
+
+		// map the recording in path and add() it, counting its bytes
+		// returns false when it can't be read or add() fails
+		bool add_file(const std::string& path);
+
+		void merge(const table& t);
+
+		// csv with a header line, or one json object per line, of every level played at least once
+		void write_csv(std::ostream& out) const;
+		void write_json(std::ostream& out) const;
+
+		std::vector<level_stats> levels;
+		std::uint64_t recordings, bad, bytes;
+		std::uint64_t unknown; // notes of a level or button the game doesn't have, e.g. from an older build
+	};
+};
+
+#endif // !_ANALYTICS_HPP
@@ -0,0 +1,275 @@
+/*
+ * cache.cpp:
+ * implements the transposition cache in cache.hpp
+ */
+
+#include "cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	// slots looked at for one level before giving up and evicting
+	const std::size_t max_probe = 8;
+
+	bool same(const solver::operation& a, const solver::operation& b) {
+		return a.type == b.type && a.n == b.n;
+	}
+};
+
+namespace solver {
+
+	cache::cache(std::size_t capacity) :
+		_capacity(std::max<std::size_t>(capacity, 1)), _memory(_capacity), _map(nullptr), _map_size(0), _hits(0), _misses(0) {
+
+		_records = _memory.data();
+	}
+
+	cache::~cache() {
+		_close();
+	}
+
+	// map the records onto a file, adopting its capacity when it already exists
+	bool cache::open(const std::string& path) {
+#if defined(_WIN32)
+		(void)path;
+		return false;
+#else
+		std::lock_guard<std::mutex> guard(_lock);
+
+		int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			::close(fd);
+			return false;
+		}
+
+		std::size_t capacity = _capacity;
+		std::size_t size = static_cast<std::size_t>(st.st_size);
+
+		// a new file, or one of another version: size it and write the header once mapped
+		// (the rest reads back as zeroes, i.e. empty records)
+		bool fresh = (size == 0);
+
+		if (!fresh) {
+			header h;
+
+			if (size < sizeof(header) || pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))
+				|| std::memcmp(h.magic, "CSC2", 4) != 0 || h.capacity == 0
+				|| size != sizeof(header) + h.capacity * sizeof(record)) {
+				::close(fd);
+				return false;
+			}
+
+			if (h.version == version)
+				capacity = static_cast<std::size_t>(h.capacity);
+			else
+				fresh = true;
+		}
+
+		if (fresh) {
+			size = sizeof(header) + capacity * sizeof(record);
+
+			if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+				::close(fd);
+				return false;
+			}
+		}
+
+		void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+
+		if (map == MAP_FAILED)
+			return false;
+
+		if (fresh) {
+			header h;
+			std::memcpy(h.magic, "CSC2", 4);
+			h.version = version;
+			h.capacity = capacity;
+			std::memcpy(map, &h, sizeof(h));
+		}
+
+		_close();
+
+		_map = map;
+		_map_size = size;
+		_capacity = capacity;
+		_records = reinterpret_cast<record*>(static_cast<char*>(map) + sizeof(header));
+		std::vector<record>().swap(_memory);
+
+		return true;
+#endif
+	}
+
+	bool cache::find(const level& l, solution& out) const {
+		auto canonical = _canonical(l.operations);
+		auto key = _hash(canonical);
+
+		std::lock_guard<std::mutex> guard(_lock);
+		const record* r = _probe(key, l);
+
+		// not held, or only known to be unsolvable within fewer moves than l allows
+		if (r->key != key || r->primary != l.primary || r->target != l.target || (!r->solved && r->moves < l.moves)) {
+			_misses++;
+			return false;
+		}
+
+		// a hash collision or a corrupt file can hold any record under a matching key
+		if (r->solved && !_replays(*r, canonical, l)) {
+			_misses++;
+			return false;
+		}
+
+		_hits++;
+		out = solution { r->solved && r->moves <= l.moves, {}, 0 };
+
+		// back from the canonical order to the first button of l that matches
+		// there always is one, as the canonical set is made from l's buttons
+		if (out.solved) {
+			for (std::size_t p = 0; p < r->count; p++) {
+				const auto& op = canonical[r->presses[p]];
+
+				for (std::size_t i = 0; i < l.operations.size(); i++) {
+					if (same(l.operations[i], op)) {
+						out.presses.push_back(i);
+						break;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void cache::store(const level& l, const solution& s) {
+		if (s.presses.size() > max_presses || l.moves < 0 || l.moves > 32767)
+			return;
+
+		auto canonical = _canonical(l.operations);
+		auto key = _hash(canonical);
+
+		std::lock_guard<std::mutex> guard(_lock);
+		record* r = _probe(key, l);
+
+		if (r->key == key && r->primary == l.primary && r->target == l.target) {
+
+			// a shortest solution is final, unless it doesn't replay, and a budget searched is only replaced by a bigger one
+			if ((r->solved && _replays(*r, canonical, l)) || (!r->solved && !s.solved && r->moves >= l.moves))
+				return;
+		}
+
+		record ret {};
+		ret.key = key;
+		ret.primary = l.primary;
+		ret.target = l.target;
+		ret.solved = s.solved;
+		ret.moves = static_cast<std::int16_t>(s.solved ? s.presses.size() : l.moves);
+		ret.count = static_cast<std::uint8_t>(s.presses.size());
+
+		for (std::size_t p = 0; p < s.presses.size(); p++) {
+			const auto& op = l.operations[s.presses[p]];
+
+			ret.presses[p] = static_cast<std::uint8_t>(std::find_if(canonical.begin(), canonical.end(),
+				[&](const operation& c) { return same(c, op); }) - canonical.begin());
+		}
+
+		*r = ret;
+	}
+
+	std::size_t cache::hits() const noexcept {
+		return _hits;
+	}
+
+	std::size_t cache::misses() const noexcept {
+		return _misses;
+	}
+
+	// sorted by kind then N with duplicates removed, as a second copy of a button can't change a solution
+	std::vector<operation> cache::_canonical(const std::vector<operation>& operations) {
+		std::vector<operation> ret(operations);
+
+		std::sort(ret.begin(), ret.end(), [](const operation& a, const operation& b) {
+			return (a.type != b.type) ? a.type < b.type : a.n < b.n;
+		});
+
+		ret.erase(std::unique(ret.begin(), ret.end(), same), ret.end());
+		return ret;
+	}
+
+	// 64 bit FNV-1a over every kind and N, never 0 as that marks an empty record
+	std::uint64_t cache::_hash(const std::vector<operation>& canonical) {
+		std::uint64_t ret = 14695981039346656037ull;
+
+		auto mix = [&](std::uint32_t value) {
+			for (int b = 0; b < 4; b++) {
+				ret ^= (value >> (8 * b)) & 0xff;
+				ret *= 1099511628211ull;
+			}
+		};
+
+		for (const auto& op : canonical) {
+			mix(static_cast<std::uint32_t>(op.type));
+			mix(static_cast<std::uint32_t>(op.n));
+		}
+
+		return ret ? ret : 1;
+	}
+
+	bool cache::_replays(const record& r, const std::vector<operation>& canonical, const level& l) {
+		if (r.count > max_presses || r.moves != r.count)
+			return false;
+
+		int value = l.primary;
+
+		for (std::size_t p = 0; p < r.count; p++) {
+			if (r.presses[p] >= canonical.size() || !canonical[r.presses[p]].apply(value, value))
+				return false;
+		}
+
+		return value == l.target;
+	}
+
+	cache::record* cache::_probe(std::uint64_t key, const level& l) const {
+		std::uint64_t h = key;
+		h ^= static_cast<std::uint32_t>(l.primary) * 0x9e3779b97f4a7c15ull;
+		h ^= static_cast<std::uint32_t>(l.target) * 0xc2b2ae3d27d4eb4full;
+		h ^= h >> 29;
+
+		record* first = &_records[h % _capacity];
+		record* empty = nullptr;
+
+		for (std::size_t i = 0; i < std::min(max_probe, _capacity); i++) {
+			record* r = &_records[(h + i) % _capacity];
+
+			if (r->key == key && r->primary == l.primary && r->target == l.target)
+				return r;
+
+			if (!empty && r->key == 0)
+				empty = r;
+		}
+
+		return empty ? empty : first;
+	}
+
+	void cache::_close() {
+#if !defined(_WIN32)
+		if (_map)
+			munmap(_map, _map_size);
+#endif
+
+		_map = nullptr;
+		_map_size = 0;
+	}
+};
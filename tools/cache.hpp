@@ -0,0 +1,111 @@
+/*
+ * cache.hpp:
+ * a transposition cache of solved levels, so re-solving a pack after a small edit skips every level seen before
+ * keyed by the operation set (in a canonical order, so shuffling the buttons doesn't matter), primary and target
+ * holding the length of the shortest solution, or the move budget already searched without finding one
+ * the records are a fixed size open addressed table, optionally memory mapped onto a file between runs
+ *
+ * whole levels rather than the (operation set, value, moves remaining) sub-problems of a search
+ * bfs() finds the shortest path in one pass over a visited set, it never asks a sub-problem twice within a level
+ * and a sub-problem's answer depends on the target, so across a pack it only repeats for levels sharing operations and target
+ * caching every state expanded would cost a record per state (thousands a level) to save what one record per level saves
+ */
+
+#ifndef _CACHE_HPP
+#define _CACHE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "solver.hpp"
+
+namespace solver {
+
+	class cache {
+	public:
+
+		// the longest solution that can be stored, longer ones are never cached
+		static const std::size_t max_presses = 16;
+
+		// bump whenever numeric.cpp changes what an operation does, or record changes layout
+		// a file written under another version is emptied by open(), as its solutions may no longer hold
+		static const std::uint32_t version = 1;
+
+		// an empty cache of capacity records held in memory
+		explicit cache(std::size_t capacity=1 << 16);
+
+		// unmaps the file, leaving every record in it
+		~cache();
+
+		cache(const cache&)=delete;
+		cache& operator=(const cache&)=delete;
+
+		// map the cache onto path, creating it with the current capacity if need be
+		// or emptying it when it was written under another version
+		// the records already held in memory are dropped
+		// returns false (leaving the cache in memory) when the file can't be mapped or isn't a cache
+		bool open(const std::string& path);
+
+		// the solution of l from an earlier store(), with expanded set to 0
+		// returns false when the cache can't tell, e.g. l was only searched to fewer moves
+		bool find(const level& l, solution& out) const;
+
+		// remember the result of searching l for up to l.moves presses
+		void store(const level& l, const solution& s);
+
+		// lookups that were answered and that weren't, since construction
+		std::size_t hits() const noexcept;
+		std::size_t misses() const noexcept;
+
+	private:
+
+		// one solved (or unsolvable) level
+		// 40 bytes, laid out the same in memory and in the file
+		struct record {
+			std::uint64_t key; // a hash of the canonical operation set, 0 for an empty record
+			std::int32_t primary, target;
+			std::int16_t moves; // the shortest solution, or the budget searched when unsolved
+			std::uint8_t solved;
+			std::uint8_t count; // number of presses
+			std::uint8_t presses[max_presses]; // indices into the canonical operation set
+		};
+
+		// the first bytes of a cache file
+		// 16 bytes, so the records after it stay 8 byte aligned
+		struct header {
+			char magic[4]; // "CSC2"
+			std::uint32_t version;
+			std::uint64_t capacity;
+		};
+
+		// the order every operation set is stored in, sorted by kind then N, and its hash
+		static std::vector<operation> _canonical(const std::vector<operation>& operations);
+		static std::uint64_t _hash(const std::vector<operation>& canonical);
+
+		// whether the presses of a solved record take l's primary to its target in r.moves presses
+		// checked before a record is trusted, as a hash collision or a corrupt file can hold anything under a key
+		static bool _replays(const record& r, const std::vector<operation>& canonical, const level& l);
+
+		// the slot holding l, otherwise the first empty slot along its probe sequence
+		// and when every one is taken the first, which store() then evicts
+		record* _probe(std::uint64_t key, const level& l) const;
+
+		// unmap the file, if any
+		void _close();
+
+		record* _records;
+		std::size_t _capacity;
+		std::vector<record> _memory; // the records when no file is mapped
+
+		void* _map; // the mapped file, or nullptr
+		std::size_t _map_size;
+
+		// store() may be called from every worker of a pack
+		mutable std::mutex _lock;
+		mutable std::size_t _hits, _misses;
+	};
+};
+
+#endif // !_CACHE_HPP
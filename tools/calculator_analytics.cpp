@@ -0,0 +1,242 @@
+/*
+ * calculator_analytics.cpp:
+ * per-level tables over any number of recorded games (see analytics.hpp), and random recordings to try it on
+ * usage:
+ * calculator_analytics [flags] PATH...          aggregate the recordings at PATH, every *.crl under a directory
+ * calculator_analytics [flags]                  aggregate the recordings listed on stdin, one path per line
+ * calculator_analytics --generate N DIR         write N random recordings to DIR
+ * flags:
+ * --threads T      workers reading recordings (default one per hardware thread)
+ * --format F       csv (default) or json, one object per level per line
+ * --seed S         random seed of generated recordings (default 1)
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <dirent.h>
+
+#include "recording_format.hpp"
+#include "scheduler.hpp"
+#include "analytics.hpp"
+#include "game.hpp"
+
+namespace {
+
+	// recordings read by one task of a parallel_for
+	const std::size_t grain = 16;
+
+	bool is_directory(const std::string& path) {
+		struct stat st;
+		return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+	}
+
+	// append every *.crl under dir to out, looking into subdirectories
+	void walk(const std::string& dir, std::vector<std::string>& out) {
+		DIR* d = opendir(dir.c_str());
+		if (!d)
+			return;
+
+		for (dirent* e; (e = readdir(d)) != nullptr;) {
+			std::string name = e->d_name;
+			if (name == "." || name == "..")
+				continue;
+
+			std::string path = dir + "/" + name;
+
+			if (is_directory(path))
+				walk(path, out);
+			else if (name.size() > 4 && name.compare(name.size() - 4, 4, ".crl") == 0)
+				out.push_back(path);
+		}
+
+		closedir(d);
+	}
+
+	void put(std::string& out, std::uint32_t value, int bytes) {
+		for (int b = 0; b < bytes; b++)
+			out.push_back(static_cast<char>((value >> (8 * b)) & 0xff));
+	}
+
+	void put_frame(std::string& out, float dt) {
+		std::uint32_t bits;
+		std::memcpy(&bits, &dt, sizeof(bits));
+
+		put(out, recording::tag::frame, 1);
+		put(out, 4, 1);
+		put(out, bits, 4);
+	}
+
+	void put_note(std::string& out, recording::note::kind what, std::size_t level, std::size_t button=0, game::verdict v=game::verdict::playing) {
+		unsigned char payload[recording::note_size];
+		recording::encode({ what, static_cast<std::uint16_t>(level), static_cast<std::uint8_t>(button), static_cast<std::uint8_t>(v) }, payload);
+
+		put(out, recording::tag::note, 1);
+		put(out, recording::note_size, 1);
+		out.append(reinterpret_cast<const char*>(payload), recording::note_size);
+	}
+
+	// a player trying a few numeric levels at random, in roughly the shape core::run records
+	// the mouse moves between presses are stood in for by records of an unused tag the size of a mouse move
+	// which every reader skips like an event
+	std::string generate(unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> frame(1.0f / 70.0f, 1.0f / 50.0f);
+		std::string out(recording::magic, sizeof(recording::magic));
+
+		put(out, 1280, 2);
+		put(out, 720, 2);
+
+		std::vector<std::size_t> numeric;
+		for (std::size_t l = 0; l < game::levels().size(); l++)
+			if (!game::levels()[l].is_tutorial())
+				numeric.push_back(l);
+
+		game::session s;
+		std::size_t level = 0;
+		bool again = false;
+
+		for (std::size_t attempts = 1 + rng() % 8; attempts > 0; attempts--) {
+			if (!again)
+				level = numeric[rng() % numeric.size()];
+
+			s.go(level);
+			s.start();
+			put_note(out, recording::note::kind::start, level);
+
+			while (s.last() == game::verdict::playing) {
+
+				// think, moving the mouse a little every frame
+				for (std::size_t f = 10 + rng() % 120; f > 0; f--) {
+					put(out, 0xff, 1);
+					put(out, 4, 1);
+					put(out, rng(), 4);
+					put_frame(out, frame(rng));
+				}
+
+				std::size_t button = rng() % s.current().operations.size();
+				put_note(out, recording::note::kind::press, level, button, s.press(button));
+				put_frame(out, frame(rng));
+			}
+
+			// sometimes AC and try again
+			again = s.last() != game::verdict::win && rng() % 2 == 0;
+
+			if (again) {
+				put_note(out, recording::note::kind::reset, level);
+				attempts++;
+			}
+		}
+
+		return out;
+	}
+};
+
+int main(int argc, char* argv[]) {
+	std::size_t threads = 0, generated = 0;
+	unsigned int seed = 1;
+	std::string format = "csv";
+	std::vector<std::string> args, paths;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string flag = argv[i];
+
+			// flags followed by a number
+			if (flag == "--threads" || flag == "--generate" || flag == "--seed") {
+				if (i + 1 >= argc)
+					throw std::invalid_argument(flag + " needs a number");
+
+				int value = numeric::from_string(argv[++i]);
+				if (value < 0)
+					throw std::invalid_argument(flag + " can't be negative");
+
+				if (flag == "--threads") threads = value;
+				else if (flag == "--generate") generated = value;
+				else seed = value;
+			}
+			else if (flag == "--format") {
+				if (i + 1 >= argc || (std::string(argv[i + 1]) != "csv" && std::string(argv[i + 1]) != "json"))
+					throw std::invalid_argument(flag + " needs csv or json");
+
+				format = argv[++i];
+			}
+			else if (flag.compare(0, 2, "--") == 0)
+				throw std::invalid_argument("unknown flag " + flag);
+			else
+				args.push_back(flag);
+		}
+
+		scheduler::pool pool(threads);
+
+		// one file per recording, as the game writes them
+		if (generated > 0) {
+			if (args.size() != 1 || !is_directory(args[0]))
+				throw std::invalid_argument("--generate needs a directory");
+
+			std::vector<int> failed(pool.size(), 0);
+			pool.parallel_for(generated, grain, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; i++) {
+					std::string name = std::to_string(i);
+					std::ofstream out(args[0] + "/" + std::string(8 - std::min<std::size_t>(name.size(), 8), '0') + name + ".crl", std::ios::binary);
+
+					std::string data = generate(seed * 1000003u + static_cast<unsigned int>(i));
+					if (!out.write(data.data(), data.size()))
+						failed[pool.worker_index()] = 1;
+				}
+			});
+
+			return std::count(failed.begin(), failed.end(), 1) == 0 ? 0 : 2;
+		}
+
+		for (const auto& a : args) {
+			if (is_directory(a))
+				walk(a, paths);
+			else
+				paths.push_back(a);
+		}
+
+		if (args.empty()) {
+			for (std::string line; std::getline(std::cin, line);)
+				if (!line.empty())
+					paths.push_back(line);
+		}
+
+		// a table per worker, merged once every recording has been read
+		auto start = std::chrono::steady_clock::now();
+		std::vector<analytics::table> tables(pool.size());
+
+		pool.parallel_for(paths.size(), grain, [&](std::size_t begin, std::size_t end) {
+			auto& t = tables[pool.worker_index()];
+
+			for (std::size_t i = begin; i < end; i++)
+				t.add_file(paths[i]);
+		});
+
+		for (std::size_t w = 1; w < tables.size(); w++)
+			tables[0].merge(tables[w]);
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const auto& t = tables[0];
+
+		if (format == "json")
+			t.write_json(std::cout);
+		else
+			t.write_csv(std::cout);
+
+		std::cerr << t.recordings << " recordings (" << t.bad << " unreadable, " << t.unknown << " unknown notes), "
+			<< t.bytes / 1000000.0 << "MB in " << seconds << "s (" << t.bytes / 1000000.0 / seconds << "MB/s on " << pool.size() << " threads)" << std::endl;
+
+		return (std::cout && t.bad == 0) ? 0 : 1;
+	} catch (std::invalid_argument& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 2;
+	}
+}
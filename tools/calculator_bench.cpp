@@ -0,0 +1,399 @@
+/*
+ * calculator_bench.cpp:
+ * micro benchmarks for the headless building blocks
+ * usage:
+ * calculator_bench batch [count]  numeric::apply_batch against one opcode::apply per number
+ * calculator_bench states [count] solver::state_set against std::unordered_set<int>
+ * calculator_bench moves [count]  random presses on the game's levels through game::session
+ * calculator_bench events [count] event::dispatch posts to 1, 10 and 1000 listeners against the unordered_map of std::function it used to keep
+ * calculator_bench send [count]   event::dispatch sends from 4 threads while one drains
+ */
+
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "state_set.hpp"
+#include "dispatch.hpp"
+#include "numeric.hpp"
+#include "game.hpp"
+
+namespace {
+
+	// run f passes times and return the best wall time of a single pass in nanoseconds
+	// the best rather than the mean, so a descheduled pass doesn't skew the result
+	double best_of(int passes, const std::function<void()>& f) {
+		double best = 0.0;
+
+		for (int p = 0; p < passes; p++) {
+			auto start = std::chrono::steady_clock::now();
+			f();
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			if (p == 0 || ns < best)
+				best = ns;
+		}
+
+		return best;
+	}
+
+	// press each batchable operation on count random numbers
+	// once through the batch kernels and once through the scalar apply
+	int bench_batch(std::size_t count) {
+		std::mt19937 rng(42);
+		std::uniform_int_distribution<int> dist(-1000000, 1000000);
+		std::uniform_int_distribution<int> wide(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+		std::vector<int> in(count), batch_out(count), scalar_out(count);
+		std::vector<std::uint8_t> batch_ok(count), scalar_ok(count);
+
+		// mostly game sized numbers, with a few huge ones so the overflow checks are exercised
+		for (std::size_t i = 0; i < count; i++)
+			in[i] = (i % 16 == 0) ? wide(rng) : dist(rng);
+
+		in[0] = std::numeric_limits<int>::min();
+
+		const char* ops[] = { "+7", "-7", "+-7", "x3", "x-3", "+/-", "|x|", "<<", "%7", "%-1", "/3", "/-1", "..5", "x^3" };
+		bool all_match = true;
+
+#if defined(__AVX2__)
+		std::cout << "batch kernels: AVX2" << std::endl;
+#else
+		std::cout << "batch kernels: scalar fallback" << std::endl;
+#endif
+
+		std::cout << std::setw(6) << "op" << std::setw(14) << "scalar ns/num" << std::setw(14) << "batch ns/num" << std::setw(10) << "speedup" << std::endl;
+
+		for (auto s : ops) {
+			auto op = numeric::opcode::from_string(s);
+
+			double scalar = best_of(20, [&]() {
+				for (std::size_t i = 0; i < count; i++)
+					scalar_ok[i] = op.apply(in[i], scalar_out[i]);
+			});
+
+			double batch = best_of(20, [&]() {
+				numeric::apply_batch(op, in.data(), batch_out.data(), batch_ok.data(), count);
+			});
+
+			// both paths must agree wherever the press succeeded
+			for (std::size_t i = 0; i < count; i++) {
+				if (scalar_ok[i] != batch_ok[i] || (scalar_ok[i] && scalar_out[i] != batch_out[i])) {
+					std::cout << "mismatch: " << in[i] << " " << s << std::endl;
+					all_match = false;
+					break;
+				}
+			}
+
+			std::cout << std::fixed << std::setprecision(3)
+				<< std::setw(6) << s
+				<< std::setw(14) << scalar / count
+				<< std::setw(14) << batch / count
+				<< std::setw(9) << scalar / batch << "x" << std::endl;
+		}
+
+		return all_match ? 0 : 1;
+	}
+
+	// bytes held by an unordered_set, assuming one heap node per value (libstdc++ and libc++ both do this)
+	std::size_t hash_memory(const std::unordered_set<int>& set) {
+		return set.bucket_count() * sizeof(void*) + set.size() * (sizeof(int) + 2 * sizeof(void*));
+	}
+
+	// insert then probe count numbers shaped like a search frontier
+	// runs of nearby numbers (+n, x10 chains) mixed with scattered ones (cat, power)
+	int bench_states(std::size_t count) {
+		std::mt19937 rng(42);
+		std::uniform_int_distribution<int> near(-1000000, 1000000);
+		std::uniform_int_distribution<int> wide(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+		std::vector<int> in(count), probe(count);
+
+		for (std::size_t i = 0; i < count; i++) {
+			in[i] = (i % 4 == 0) ? wide(rng) : near(rng);
+			probe[i] = (i % 2 == 0) ? in[(i * 7) % count] : near(rng);
+		}
+
+		std::size_t hash_size = 0, hash_bytes = 0, hash_hits = 0;
+		std::size_t set_size = 0, set_bytes = 0, set_hits = 0;
+
+		double hash_insert = best_of(5, [&]() {
+			std::unordered_set<int> set;
+			for (auto v : in)
+				set.insert(v);
+
+			hash_size = set.size();
+			hash_bytes = hash_memory(set);
+		});
+
+		double set_insert = best_of(5, [&]() {
+			solver::state_set set;
+			for (auto v : in)
+				set.insert(v);
+
+			set_size = set.size();
+			set_bytes = set.memory();
+		});
+
+		std::unordered_set<int> hash(in.begin(), in.end());
+		solver::state_set set;
+		for (auto v : in)
+			set.insert(v);
+
+		double hash_probe = best_of(5, [&]() {
+			hash_hits = 0;
+			for (auto v : probe)
+				hash_hits += hash.count(v);
+		});
+
+		double set_probe = best_of(5, [&]() {
+			set_hits = 0;
+			for (auto v : probe)
+				set_hits += set.contains(v);
+		});
+
+		std::cout << std::setw(14) << "" << std::setw(14) << "insert ns/num" << std::setw(14) << "probe ns/num" << std::setw(14) << "bytes/num" << std::endl;
+
+		std::cout << std::fixed << std::setprecision(3)
+			<< std::setw(14) << "unordered_set"
+			<< std::setw(14) << hash_insert / count
+			<< std::setw(14) << hash_probe / count
+			<< std::setw(14) << static_cast<double>(hash_bytes) / hash_size << std::endl
+			<< std::setw(14) << "state_set"
+			<< std::setw(14) << set_insert / count
+			<< std::setw(14) << set_probe / count
+			<< std::setw(14) << static_cast<double>(set_bytes) / set_size << std::endl;
+
+		// both must hold the same numbers
+		if (hash_size != set_size || hash_hits != set_hits) {
+			std::cout << "mismatch: " << hash_size << " " << set_size << " " << hash_hits << " " << set_hits << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// play count random presses across every numeric level through a game::session
+	// moving on to the next numeric level once one is won, lost or ERR!
+	int bench_moves(std::size_t count) {
+		std::mt19937 rng(42);
+		std::size_t levels = 0;
+
+		for (const auto& l : game::levels())
+			levels += !l.is_tutorial();
+
+		// the buttons to press, drawn up front so the rng isn't timed
+		std::vector<std::uint32_t> picks(count);
+		for (auto& p : picks)
+			p = rng();
+
+		std::size_t outcomes[4] = { 0, 0, 0, 0 };
+
+		double ns = best_of(5, [&]() {
+			game::session s;
+			std::fill(std::begin(outcomes), std::end(outcomes), 0);
+
+			for (auto p : picks) {
+				while (s.current().is_tutorial() || s.last() != game::verdict::playing) {
+					if (!s.next())
+						s.go(0);
+
+					s.start();
+				}
+
+				outcomes[static_cast<int>(s.press(p % s.current().operations.size()))]++;
+			}
+		});
+
+		std::cout << std::fixed << std::setprecision(3)
+			<< count << " presses on " << levels << " levels: "
+			<< ns / count << " ns/press, " << std::setprecision(1) << count / ns * 1000.0 << "M presses/s" << std::endl
+			<< "playing " << outcomes[0] << ", win " << outcomes[1] << ", lose " << outcomes[2] << ", err " << outcomes[3] << std::endl;
+
+		return 0;
+	}
+
+	// the listener storage event::dispatch had before slot_map.hpp and delegate.hpp, kept to compare against
+	template <typename T>
+	struct map_dispatch {
+		static std::size_t _id;
+		static std::unordered_map<std::size_t, std::function<void(const T&)>> _listeners;
+
+		static std::size_t connect(std::function<void(const T&)> thing) {
+			_listeners[_id] = thing;
+			return _id++;
+		}
+
+		static void disconnect(std::size_t id) {
+			_listeners.erase(id);
+		}
+
+		static void post(const T& t) {
+			for (const auto& x : _listeners)
+				x.second(t);
+		}
+	};
+
+	template <typename T> std::size_t map_dispatch<T>::_id;
+	template <typename T> std::unordered_map<std::size_t, std::function<void(const T&)>> map_dispatch<T>::_listeners;
+
+	// the shape of a mouse move, the most posted event
+	struct moved {
+		int x, y;
+	};
+
+	// the same event listened to by objects, the way buttons listen to the mouse
+	struct pointer {
+		int x, y;
+	};
+
+	struct counter : public event::class_listener<pointer> {
+		long long& total;
+
+		explicit counter(long long& t) : total(t) { }
+
+		virtual void listen(const pointer& p) override { total += p.x; }
+	};
+
+	// post count events to 1, 10 and 1000 listeners each adding to a total, through both storages
+	// and through event::dispatch again to class_listeners
+	int bench_events(std::size_t count) {
+		std::cout << std::setw(10) << "listeners" << std::setw(16) << "unordered_map" << std::setw(16) << "slot_map"
+			<< std::setw(16) << "class_listener" << "  (ns/post)" << std::endl;
+
+		for (std::size_t listeners : { 1, 10, 1000 }) {
+			std::vector<long long> totals(listeners, 0);
+			std::vector<std::size_t> ids;
+			std::vector<event::connection<moved>> connections;
+			std::vector<std::unique_ptr<counter>> counters;
+
+			for (std::size_t l = 0; l < listeners; l++) {
+				auto& total = totals[l];
+				ids.push_back(map_dispatch<moved>::connect([&total](const moved& m) { total += m.x; }));
+				connections.push_back(event::dispatch<moved>::connect([&total](const moved& m) { total += m.y; }));
+				counters.emplace_back(new counter(total));
+			}
+
+			// many listeners get fewer posts, so every row is count deliveries
+			std::size_t posts = std::max<std::size_t>(count / listeners, 1);
+
+			double map = best_of(3, [&]() {
+				for (std::size_t i = 0; i < posts; i++)
+					map_dispatch<moved>::post(moved { 1, 0 });
+			});
+
+			double slots = best_of(3, [&]() {
+				for (std::size_t i = 0; i < posts; i++)
+					event::dispatch<moved>::post(moved { 0, 1 });
+			});
+
+			double objects = best_of(3, [&]() {
+				for (std::size_t i = 0; i < posts; i++)
+					event::dispatch<pointer>::post(pointer { 1, 0 });
+			});
+
+			for (auto id : ids)
+				map_dispatch<moved>::disconnect(id);
+
+			for (auto& c : connections)
+				c.disconnect();
+
+			std::cout << std::fixed << std::setprecision(2)
+				<< std::setw(10) << listeners << std::setw(16) << map / posts << std::setw(16) << slots / posts
+				<< std::setw(16) << objects / posts << std::endl;
+
+			// all three must have reached every listener on every post
+			for (auto t : totals) {
+				if (t != 9 * static_cast<long long>(posts)) {
+					std::cout << "mismatch: " << t << std::endl;
+					return 1;
+				}
+			}
+		}
+
+		return 0;
+	}
+
+	// a result handed from a worker thread to the main one
+	struct sent {
+		std::size_t worker, index;
+	};
+
+	// send count events from 4 threads, draining them on this one as they arrive
+	int bench_send(std::size_t count) {
+		const std::size_t workers = 4;
+		std::vector<std::size_t> next(workers, 0);
+		std::size_t received = 0, drains = 0;
+		bool ordered = true;
+
+		auto c = event::dispatch<sent>::connect([&](const sent& s) {
+			ordered &= (s.index == next[s.worker]++);
+			received++;
+		});
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+
+		for (std::size_t w = 0; w < workers; w++) {
+			threads.emplace_back([w, count, workers]() {
+				for (std::size_t i = 0; i < count / workers; i++)
+					event::dispatch<sent>::send(sent { w, i });
+			});
+		}
+
+		while (received < count / workers * workers) {
+			event::drain();
+			drains++;
+		}
+
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		for (auto& t : threads)
+			t.join();
+
+		c.disconnect();
+
+		std::cout << std::fixed << std::setprecision(1)
+			<< received << " events from " << workers << " threads in " << drains << " drains: "
+			<< ns / received << " ns/event, " << received / ns * 1000.0 << "M events/s" << std::endl;
+
+		// every thread's events must arrive in the order it sent them
+		if (!ordered) {
+			std::cout << "out of order" << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+};
+
+int main(int argc, char* argv[]) {
+	std::string what = (argc > 1) ? argv[1] : "";
+
+	if (what == "batch")
+		return bench_batch((argc > 2) ? std::stoul(argv[2]) : 1 << 20);
+
+	if (what == "states")
+		return bench_states((argc > 2) ? std::stoul(argv[2]) : 1 << 22);
+
+	if (what == "moves")
+		return bench_moves((argc > 2) ? std::stoul(argv[2]) : 1 << 24);
+
+	if (what == "events")
+		return bench_events((argc > 2) ? std::stoul(argv[2]) : 10000000);
+
+	if (what == "send")
+		return bench_send((argc > 2) ? std::stoul(argv[2]) : 10000000);
+
+	std::cerr << "usage: calculator_bench batch|states|moves|events|send [count]" << std::endl;
+	return 2;
+}
@@ -0,0 +1,146 @@
+/*
+ * calculator_levelgen.cpp:
+ * command line front end to the level generator
+ * usage:
+ * calculator_levelgen [flags]
+ * flags:
+ * --count N        levels to generate (default 10)
+ * --moves M        presses in the shortest solution (default 4)
+ * --buttons B      operations per level, 1 to 6 (default 3)
+ * --seed S         random seed, the same seed and flags give the same levels (default 1)
+ * --candidates C   give up after screening this many candidates (default 1000 per level)
+ * --any-solution   allow more than one shortest solution
+ * --allow-unused   allow the shortest solution to skip a button
+ * --pack           print levels for calculator_solver instead of as game.cpp code
+ * --threads T      workers screening candidates (default one per hardware thread)
+ *                  the levels only depend on the seed, never on the number of threads
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "generator.hpp"
+#include "scheduler.hpp"
+#include "solver.hpp"
+
+namespace {
+
+	// candidates screened from one random stream
+	// a stream is seeded by the seed and its index, so the order streams are screened in doesn't matter
+	const std::size_t stream_length = 64;
+};
+
+int main(int argc, char* argv[]) {
+	generator::constraints c { 4, 3, true, true, 999999 };
+	std::size_t count = 10, candidates = 0, threads = 0;
+	unsigned int seed = 1;
+	bool pack = false;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string flag = argv[i];
+
+			// flags followed by a number
+			if (flag == "--count" || flag == "--moves" || flag == "--buttons" || flag == "--seed" || flag == "--candidates" || flag == "--threads") {
+				if (i + 1 >= argc)
+					throw std::invalid_argument(flag + " needs a number");
+
+				int value = numeric::from_string(argv[++i]);
+				if (value < 0)
+					throw std::invalid_argument(flag + " can't be negative");
+
+				if (flag == "--count") count = value;
+				else if (flag == "--moves") c.moves = value;
+				else if (flag == "--buttons") c.buttons = value;
+				else if (flag == "--seed") seed = value;
+				else if (flag == "--threads") threads = value;
+				else candidates = value;
+			}
+			else if (flag == "--any-solution") c.unique = false;
+			else if (flag == "--allow-unused") c.every_button = false;
+			else if (flag == "--pack") pack = true;
+			else throw std::invalid_argument("unknown flag " + flag);
+		}
+	} catch (std::invalid_argument& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 2;
+	}
+
+	if (c.moves < 1 || c.buttons < 1) {
+		std::cerr << "error: a level needs at least one move and one button" << std::endl;
+		return 2;
+	}
+
+	if (c.buttons > generator::max_buttons) {
+		std::cerr << "error: a level has at most " << generator::max_buttons << " buttons" << std::endl;
+		return 2;
+	}
+
+	if (candidates == 0)
+		candidates = count * 1000;
+
+	scheduler::pool pool(threads);
+	std::size_t kept = 0, screened = 0, streams = 0;
+	std::atomic<std::size_t> disagreements(0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	// screen a round of streams across every worker, then keep levels in stream order
+	// a round is a few streams per worker so stealing can even out slow candidates
+	while (kept < count && screened < candidates) {
+		std::size_t round = std::min(pool.size() * 8, (candidates - screened + stream_length - 1) / stream_length);
+		std::vector<std::vector<solver::level>> found(round);
+
+		pool.parallel_for(round, 1, [&](std::size_t begin, std::size_t end) {
+			std::uniform_int_distribution<int> primaries(-25, 150);
+
+			for (std::size_t r = begin; r < end; r++) {
+				std::seed_seq seq { seed, static_cast<unsigned int>(streams + r) };
+				std::mt19937 rng(seq);
+
+				for (std::size_t i = 0; i < stream_length && (streams + r) * stream_length + i < candidates; i++) {
+					solver::level l;
+
+					if (!generator::pick_target(primaries(rng), generator::sample_operations(rng, c.buttons), c, rng, l))
+						continue;
+
+					// the generator and the solver must agree on the difficulty
+					// anything else is a bug in one of them
+					auto s = solver::bfs(l);
+					if (!s.solved || static_cast<int>(s.presses.size()) != c.moves) {
+						disagreements++;
+						continue;
+					}
+
+					found[r].push_back(l);
+				}
+			}
+		});
+
+		for (const auto& levels : found) {
+			for (const auto& l : levels) {
+				if (kept < count) {
+					std::cout << (pack ? l.get_string() : generator::as_cpp(l)) << std::endl;
+					kept++;
+				}
+			}
+		}
+
+		screened = std::min(candidates, (streams + round) * stream_length);
+		streams += round;
+	}
+
+	if (disagreements > 0)
+		std::cerr << "warning: solver disagrees on " << disagreements << " generated levels" << std::endl;
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cerr << "kept " << kept << " of " << screened << " candidates in " << seconds << "s ("
+		<< static_cast<std::size_t>(screened / seconds) << " candidates/s on " << pool.size() << " threads)" << std::endl;
+
+	return (kept == count) ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+/*
+ * calculator_solver.cpp:
+ * command line front end to the headless solver
+ * usage:
+ * calculator_solver [flags] primary moves target op...  solve a single level e.g. 2 2 5 +1 +2
+ * calculator_solver [flags]                             solve a level pack from stdin, one level per line
+ * calculator_solver --table csv|binary primary moves op...  every number reachable from primary e.g. 2 2 +1 +2
+ * flags:
+ * --bidirectional  meet in the middle, much faster for long move budgets
+ * --threads T      workers solving a pack (default one per hardware thread)
+ * --table F        print the reachability table (see solver::table) as csv or binary instead
+ * --cache FILE     reuse the solutions stored in FILE (see solver::cache), storing new ones there
+ */
+
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "scheduler.hpp"
+#include "cache.hpp"
+#include "solver.hpp"
+
+namespace {
+
+	// the search used for every level
+	solver::solution (*search)(const solver::level&) = solver::bfs;
+
+	// solutions of earlier runs, or nullptr to always search
+	std::unique_ptr<solver::cache> known;
+
+	// the shortest solution of a level (or the lack of one) and how long it took to find
+	struct result {
+		solver::solution s;
+		long long us;
+	};
+
+	result solve(const solver::level& l) {
+		auto start = std::chrono::steady_clock::now();
+		solver::solution s;
+
+		if (!known || !known->find(l, s)) {
+			s = search(l);
+
+			if (known)
+				known->store(l, s);
+		}
+
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+		return result { s, us };
+	}
+
+	// returns whether the level could be solved
+	bool report(const solver::level& l, const result& r) {
+		std::cout << l.get_string() << " : ";
+
+		if (r.s.solved)
+			std::cout << r.s.get_string(l);
+		else
+			std::cout << "none within " << l.moves << " moves";
+
+		std::cout << " (" << r.s.expanded << " states, " << r.us << "us)" << std::endl;
+
+		return r.s.solved;
+	}
+};
+
+int main(int argc, char* argv[]) {
+	bool all_solved = true;
+	std::size_t threads = 0;
+	std::string table;
+	int first = 1;
+
+	try {
+
+		// leading --flags, a single - is left alone as it starts a sub operation e.g. -7
+		for (; first < argc && std::string(argv[first]).compare(0, 2, "--") == 0; first++) {
+			std::string flag = argv[first];
+
+			if (flag == "--bidirectional")
+				search = solver::bidirectional;
+			else if (flag == "--threads") {
+				if (first + 1 >= argc)
+					throw std::invalid_argument(flag + " needs a number");
+
+				int value = numeric::from_string(argv[++first]);
+				if (value < 0)
+					throw std::invalid_argument(flag + " can't be negative");
+
+				threads = value;
+			}
+			else if (flag == "--table") {
+				if (first + 1 >= argc || (std::string(argv[first + 1]) != "csv" && std::string(argv[first + 1]) != "binary"))
+					throw std::invalid_argument(flag + " needs csv or binary");
+
+				table = argv[++first];
+			}
+			else if (flag == "--cache") {
+				if (first + 1 >= argc)
+					throw std::invalid_argument(flag + " needs a file");
+
+				known.reset(new solver::cache());
+				if (!known->open(argv[++first]))
+					throw std::invalid_argument("can't open " + std::string(argv[first]) + " as a cache");
+			}
+			else throw std::invalid_argument("unknown flag " + flag);
+		}
+
+		// one search from a start value, keeping everything it reaches
+		if (!table.empty()) {
+			if (argc - first < 2)
+				throw std::invalid_argument("expected 'primary moves op...' after --table");
+
+			std::vector<solver::operation> operations;
+			for (int i = first + 2; i < argc; i++)
+				operations.push_back(numeric::opcode::from_string(argv[i]));
+
+			auto t = solver::reach(numeric::from_string(argv[first]), numeric::from_string(argv[first + 1]), operations);
+
+			if (table == "csv")
+				t.write_csv(std::cout);
+			else
+				t.write_binary(std::cout);
+
+			return std::cout ? 0 : 2;
+		}
+
+		// a level given on the command line
+		else if (argc > first) {
+			std::string line;
+			for (int i = first; i < argc; i++)
+				line += std::string(argv[i]) + " ";
+
+			auto l = solver::level::from_string(line);
+			all_solved = report(l, solve(l));
+		}
+
+		// a level pack on stdin, skipping blank lines and # comments
+		// every level is searched independently, so they are spread across the pool and reported in order
+		else {
+			std::vector<solver::level> levels;
+
+			for (std::string line; std::getline(std::cin, line);) {
+				if (line.find_first_not_of(" \t\r") == std::string::npos || line[0] == '#')
+					continue;
+
+				levels.push_back(solver::level::from_string(line));
+			}
+
+			std::vector<result> results(levels.size());
+			scheduler::pool pool(threads);
+
+			pool.parallel_for(levels.size(), 1, [&](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; i++)
+					results[i] = solve(levels[i]);
+			});
+
+			for (std::size_t i = 0; i < levels.size(); i++)
+				all_solved &= report(levels[i], results[i]);
+		}
+
+		if (known)
+			std::cerr << "cache: " << known->hits() << " hits, " << known->misses() << " misses" << std::endl;
+	} catch (std::invalid_argument& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 2;
+	}
+
+	return all_solved ? 0 : 1;
+}
@@ -0,0 +1,403 @@
+/*
+ * calculator_validate.cpp:
+ * a long running service checking player solutions, and a load generator for it
+ * requests and responses are the binary frames of validate.hpp
+ * usage:
+ * calculator_validate [flags]                     answer requests from stdin on stdout until stdin closes
+ * calculator_validate [flags] --socket PATH       answer every connection to a unix domain socket
+ * calculator_validate --generate N                write N random requests to stdout
+ * calculator_validate --load N --socket PATH      send N random requests to a running service, reporting throughput and latency
+ * flags:
+ * --threads T      workers checking requests (default one per hardware thread)
+ * --text           answer as "id VERDICT" lines instead of frames
+ * --window W       requests the load generator keeps in flight (default 4096)
+ * --seed S         random seed of generated requests (default 1)
+ */
+
+#include <condition_variable>
+#include <algorithm>
+#include <iostream>
+#include <csignal>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "scheduler.hpp"
+#include "validate.hpp"
+
+namespace {
+
+	// requests checked together, small enough that answers stream back steadily
+	const std::size_t batch_size = 4096;
+
+	// batches read ahead of the one being checked
+	const std::size_t read_ahead = 4;
+
+	// requests checked by one task of a parallel_for
+	const std::size_t grain = 256;
+
+	bool text = false;
+
+	// write all of data, returns false once the other end has gone
+	bool write_all(int fd, const std::string& data) {
+		for (std::size_t at = 0; at < data.size();) {
+			ssize_t n = ::write(fd, data.data() + at, data.size() - at);
+			if (n <= 0)
+				return false;
+
+			at += n;
+		}
+
+		return true;
+	}
+
+	// batches handed from the reading thread to the checking one
+	// a null batch marks the end of the input
+	class queue {
+	public:
+		void push(std::unique_ptr<validate::batch> b) {
+			std::unique_lock<std::mutex> lock(_lock);
+			_space.wait(lock, [this]() { return _batches.size() < read_ahead; });
+			_batches.push_back(std::move(b));
+			_ready.notify_one();
+		}
+
+		std::unique_ptr<validate::batch> pop() {
+			std::unique_lock<std::mutex> lock(_lock);
+			_ready.wait(lock, [this]() { return !_batches.empty(); });
+
+			auto ret = std::move(_batches.front());
+			_batches.pop_front();
+			_space.notify_one();
+
+			return ret;
+		}
+
+	private:
+		std::mutex _lock;
+		std::condition_variable _ready, _space;
+		std::deque<std::unique_ptr<validate::batch>> _batches;
+	};
+
+	// answer every request read from in on out, until in closes
+	// one thread reads and parses while this one checks the previous batch across the pool and writes its answers
+	std::size_t serve(int in, int out, scheduler::pool& pool) {
+		queue q;
+
+		std::thread reader([&]() {
+			std::vector<char> buffer(1 << 16);
+			std::size_t held = 0;
+			auto b = std::unique_ptr<validate::batch>(new validate::batch());
+
+			while (true) {
+				if (held == buffer.size())
+					buffer.resize(buffer.size() * 2);
+
+				ssize_t n = ::read(in, buffer.data() + held, buffer.size() - held);
+				if (n <= 0)
+					break;
+
+				held += n;
+
+				// everything read so far goes out now, rather than wait for a full batch
+				std::size_t used = 0;
+				while (true) {
+					used += b->parse(buffer.data() + used, held - used, batch_size - b->size());
+
+					if (b->size() < batch_size)
+						break;
+
+					q.push(std::move(b));
+					b.reset(new validate::batch());
+				}
+
+				if (b->size() > 0) {
+					q.push(std::move(b));
+					b.reset(new validate::batch());
+				}
+
+				std::copy(buffer.begin() + used, buffer.begin() + held, buffer.begin());
+				held -= used;
+			}
+
+			if (held > 0)
+				std::cerr << "warning: " << held << " bytes of an incomplete request ignored" << std::endl;
+
+			q.push(nullptr);
+		});
+
+		std::size_t answered = 0;
+		bool open = true;
+		std::string answers;
+
+		for (auto b = q.pop(); b; b = q.pop()) {
+			pool.parallel_for(b->size(), grain, [&](std::size_t begin, std::size_t end) {
+				game::session s;
+
+				for (std::size_t i = begin; i < end; i++)
+					validate::check(s, *b, i);
+			});
+
+			answers.clear();
+
+			if (text) {
+				for (std::size_t i = 0; i < b->size(); i++)
+					answers += std::to_string(b->ids[i]) + " " + validate::get_string(b->verdicts[i]) + "\n";
+			} else {
+				b->write_responses(answers);
+			}
+
+			// keep draining the input after the other end goes, so the reader can finish
+			open = open && write_all(out, answers);
+			answered += b->size();
+		}
+
+		reader.join();
+		return answered;
+	}
+
+	// a socket address for path, throws std::invalid_argument when it's too long
+	sockaddr_un address(const std::string& path) {
+		sockaddr_un ret {};
+		ret.sun_family = AF_UNIX;
+
+		if (path.size() >= sizeof(ret.sun_path))
+			throw std::invalid_argument("socket path too long: " + path);
+
+		std::copy(path.begin(), path.end(), ret.sun_path);
+		return ret;
+	}
+
+	// random requests for numeric levels, mostly well formed
+	// one in 64 presses a button the level doesn't have
+	validate::batch generate(std::size_t count, unsigned int seed) {
+		std::mt19937 rng(seed);
+		std::vector<std::uint16_t> numeric;
+		std::vector<std::uint8_t> presses;
+		validate::batch ret;
+
+		for (std::size_t l = 0; l < game::levels().size(); l++)
+			if (!game::levels()[l].is_tutorial())
+				numeric.push_back(static_cast<std::uint16_t>(l));
+
+		for (std::size_t i = 0; i < count; i++) {
+			auto level = numeric[rng() % numeric.size()];
+			const auto& l = game::levels()[level];
+
+			presses.resize(1 + rng() % l.moves);
+			for (auto& p : presses)
+				p = static_cast<std::uint8_t>((rng() % 64 == 0) ? l.operations.size() : rng() % l.operations.size());
+
+			ret.push(static_cast<std::uint32_t>(i), level, presses.data(), presses.size());
+		}
+
+		return ret;
+	}
+
+	// send count requests to the service at path, at most window in flight
+	// and report the requests answered per second and the latency of each
+	int load(const std::string& path, std::size_t count, std::size_t window, unsigned int seed) {
+		auto requests = generate(count, seed);
+		auto addr = address(path);
+
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+			std::cerr << "error: can't connect to " << path << std::endl;
+			return 2;
+		}
+
+		typedef std::chrono::steady_clock clock;
+		std::vector<clock::time_point> sent(count);
+		std::vector<double> latency(count);
+		std::atomic<std::size_t> stamped(0), received(0); // sent[i] is written for every i < stamped
+		std::size_t verdicts[5] = { 0, 0, 0, 0, 0 };
+
+		auto start = clock::now();
+
+		// send in slices, waiting while window requests are unanswered
+		std::thread sender([&]() {
+			std::string frames;
+			validate::batch slice;
+
+			for (std::size_t at = 0; at < count;) {
+				while (at - received.load(std::memory_order_acquire) >= window)
+					std::this_thread::yield();
+
+				std::size_t end = std::min(count, std::min(at + grain, received.load(std::memory_order_acquire) + window));
+
+				slice.clear();
+				for (std::size_t i = at; i < end; i++) {
+					auto p = requests.presses.data() + requests.offsets[i];
+					slice.push(requests.ids[i], requests.levels[i], p, requests.offsets[i + 1] - requests.offsets[i]);
+				}
+
+				frames.clear();
+				slice.write_requests(frames);
+
+				auto now = clock::now();
+				for (std::size_t i = at; i < end; i++)
+					sent[i] = now;
+
+				stamped.store(end, std::memory_order_release);
+
+				if (!write_all(fd, frames))
+					break;
+
+				at = end;
+			}
+
+			shutdown(fd, SHUT_WR);
+		});
+
+		std::vector<char> buffer(1 << 16);
+		std::size_t held = 0;
+
+		while (received < count) {
+			ssize_t n = ::read(fd, buffer.data() + held, buffer.size() - held);
+			if (n <= 0)
+				break;
+
+			held += n;
+			auto now = clock::now();
+			std::size_t known = stamped.load(std::memory_order_acquire);
+
+			std::size_t used = 0;
+			for (; held - used >= validate::response_size; used += validate::response_size) {
+				const auto* frame = reinterpret_cast<const unsigned char*>(buffer.data() + used);
+				std::uint32_t id = frame[0] | (frame[1] << 8) | (frame[2] << 16) | (static_cast<std::uint32_t>(frame[3]) << 24);
+
+				if (id < known)
+					latency[id] = std::chrono::duration<double, std::micro>(now - sent[id]).count();
+
+				verdicts[std::min<std::size_t>(frame[4], 4)]++;
+				received++;
+			}
+
+			std::copy(buffer.begin() + used, buffer.begin() + held, buffer.begin());
+			held -= used;
+		}
+
+		double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+		sender.join();
+		close(fd);
+
+		std::size_t answered = received.load();
+		if (answered < count) {
+			std::cerr << "error: only " << answered << " of " << count << " requests were answered" << std::endl;
+			return 1;
+		}
+
+		std::sort(latency.begin(), latency.end());
+
+		std::cout << std::fixed << std::setprecision(1)
+			<< count << " requests in " << seconds << "s: " << count / seconds << " requests/s" << std::endl
+			<< "latency us: p50 " << latency[count / 2] << ", p99 " << latency[count * 99 / 100] << ", max " << latency.back() << std::endl;
+
+		for (int v = 0; v < 5; v++)
+			std::cout << validate::get_string(static_cast<validate::verdict>(v)) << " " << verdicts[v] << (v < 4 ? ", " : "\n");
+
+		return 0;
+	}
+};
+
+int main(int argc, char* argv[]) {
+	std::size_t threads = 0, generated = 0, loaded = 0, window = 4096;
+	unsigned int seed = 1;
+	std::string path;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string flag = argv[i];
+
+			// flags followed by a number
+			if (flag == "--threads" || flag == "--generate" || flag == "--load" || flag == "--window" || flag == "--seed") {
+				if (i + 1 >= argc)
+					throw std::invalid_argument(flag + " needs a number");
+
+				int value = numeric::from_string(argv[++i]);
+				if (value < 0)
+					throw std::invalid_argument(flag + " can't be negative");
+
+				if (flag == "--threads") threads = value;
+				else if (flag == "--generate") generated = value;
+				else if (flag == "--load") loaded = value;
+				else if (flag == "--window") window = std::max(value, 1);
+				else seed = value;
+			}
+			else if (flag == "--socket") {
+				if (i + 1 >= argc)
+					throw std::invalid_argument(flag + " needs a path");
+
+				path = argv[++i];
+			}
+			else if (flag == "--text") text = true;
+			else throw std::invalid_argument("unknown flag " + flag);
+		}
+
+		if (generated > 0) {
+			std::string frames;
+			generate(generated, seed).write_requests(frames);
+
+			return write_all(STDOUT_FILENO, frames) ? 0 : 2;
+		}
+
+		if (loaded > 0) {
+			if (path.empty())
+				throw std::invalid_argument("--load needs --socket");
+
+			return load(path, loaded, window, seed);
+		}
+
+		// a client going away mid answer is its problem, not the service's
+		std::signal(SIGPIPE, SIG_IGN);
+
+		scheduler::pool pool(threads);
+
+		if (path.empty()) {
+			auto start = std::chrono::steady_clock::now();
+			std::size_t answered = serve(STDIN_FILENO, STDOUT_FILENO, pool);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::cerr << "answered " << answered << " requests in " << seconds << "s ("
+				<< static_cast<std::size_t>(answered / seconds) << " requests/s on " << pool.size() << " threads)" << std::endl;
+
+			return 0;
+		}
+
+		// every connection is served by its own thread, sharing the pool
+		auto addr = address(path);
+		int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		unlink(path.c_str());
+
+		if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+			std::cerr << "error: can't listen on " << path << std::endl;
+			return 2;
+		}
+
+		std::cerr << "listening on " << path << std::endl;
+
+		for (int fd; (fd = accept(listener, nullptr, nullptr)) >= 0;) {
+			std::thread([fd, &pool]() {
+				serve(fd, fd, pool);
+				close(fd);
+			}).detach();
+		}
+	} catch (std::invalid_argument& e) {
+		std::cerr << "error: " << e.what() << std::endl;
+		return 2;
+	}
+
+	return 2;
+}
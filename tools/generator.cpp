@@ -0,0 +1,128 @@
+/*
+ * generator.cpp:
+ * implements the level generator in generator.hpp
+ */
+
+#include "generator.hpp"
+
+#include <algorithm>
+
+namespace {
+
+	typedef numeric::opcode::kind kind;
+
+	// an entry of the catalogue: an operation and the range its N is drawn from
+	struct entry {
+		kind type;
+		int low, high;
+	};
+
+	// every numeric class of default_operation, with the sort of N the hand made levels use
+	// mul and divi skip the values that would make them do nothing, see sample_operations()
+	const entry catalogue[] = {
+		{ kind::add, 1, 9 },
+		{ kind::sub, 1, 9 },
+		{ kind::mul, -4, 9 },
+		{ kind::divi, -4, 9 },
+		{ kind::mod, 2, 9 },
+		{ kind::cat, 0, 9 },
+		{ kind::del, 0, 0 },
+		{ kind::sign_invert, 0, 0 },
+		{ kind::sign_posative, 0, 0 },
+		{ kind::power, 2, 3 },
+	};
+
+	// the helper game.cpp makes an opcode with e.g. add(1) or del()
+	std::string as_cpp(numeric::opcode op) {
+		switch (op.type) {
+			case kind::add: return "add(" + std::to_string(op.n) + ")";
+			case kind::sub: return "sub(" + std::to_string(op.n) + ")";
+			case kind::mul: return "mul(" + std::to_string(op.n) + ")";
+			case kind::divi: return "divi(" + std::to_string(op.n) + ")";
+			case kind::mod: return "mod(" + std::to_string(op.n) + ")";
+			case kind::cat: return "cat(" + std::to_string(op.n) + ")";
+			case kind::del: return "del()";
+			case kind::sign_invert: return "sign_invert()";
+			case kind::sign_posative: return "sign_posative()";
+			case kind::power: return "power(" + std::to_string(op.n) + ")";
+		}
+
+		return "";
+	}
+};
+
+namespace generator {
+
+	// randomly pick a set of distinct operations from the default_operation catalogue
+	std::vector<numeric::opcode> sample_operations(std::mt19937& rng, std::size_t count) {
+		std::uniform_int_distribution<std::size_t> pick(0, sizeof(catalogue) / sizeof(catalogue[0]) - 1);
+		std::vector<numeric::opcode> ret;
+
+		while (ret.size() < count) {
+			const entry& e = catalogue[pick(rng)];
+			numeric::opcode op { e.type, std::uniform_int_distribution<int>(e.low, e.high)(rng) };
+
+			// x0, x1, /0, /1 and /-1 are either pointless or always an ERR!
+			if ((e.type == kind::mul || e.type == kind::divi) && op.n >= -1 && op.n <= 1)
+				continue;
+
+			// two identical buttons can never have a unique solution
+			bool duplicate = false;
+			for (const auto& other : ret)
+				duplicate |= (other.type == op.type && other.n == op.n);
+
+			if (!duplicate)
+				ret.push_back(op);
+		}
+
+		return ret;
+	}
+
+	// pick a qualifying target from the reachability table of primary
+	bool pick_target(int primary, const std::vector<numeric::opcode>& operations,
+		const constraints& c, std::mt19937& rng, solver::level& out) {
+
+		thread_local solver::table t;
+		solver::reach(primary, c.moves, operations, t);
+
+		// pick uniformly between every qualifying target (reservoir sampling)
+		// so one candidate never favours the numbers its first button reaches
+		std::size_t qualified = 0;
+		std::vector<std::uint8_t> used(operations.size());
+
+		// every number first reached in the last layer has a shortest solution of exactly c.moves
+		for (std::size_t e = 0; e < t.entries.size(); e++) {
+			const auto& r = t.entries[e];
+
+			if (r.moves != c.moves || r.value > c.max_value || r.value < -c.max_value || (c.unique && r.paths != 1))
+				continue;
+
+			// walk back along the (first found) shortest path and check every button was pressed
+			if (c.every_button) {
+				std::fill(used.begin(), used.end(), 0);
+
+				for (auto at = e; t.entries[at].moves > 0; at = t.entries[at].parent)
+					used[t.entries[at].press] = 1;
+
+				if (std::find(used.begin(), used.end(), 0) != used.end())
+					continue;
+			}
+
+			if (std::uniform_int_distribution<std::size_t>(0, qualified++)(rng) == 0)
+				out = solver::level { primary, c.moves, r.value, operations };
+		}
+
+		return qualified > 0;
+	}
+
+	// the level as it would be written in game::levels() of game.cpp
+	std::string as_cpp(const solver::level& l) {
+		std::string ops;
+
+		for (const auto& op : l.operations)
+			ops += (ops.empty() ? "" : ", ") + ::as_cpp(op);
+
+		return "numeric_level(" + std::to_string(l.primary) + ", " + std::to_string(l.moves) + ", "
+			+ std::to_string(l.target) + ", { " + ops + " }),";
+	}
+};
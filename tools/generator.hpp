@@ -0,0 +1,46 @@
+/*
+ * generator.hpp:
+ * procedurally generate levels, keeping only those that meet a set of constraints
+ * e.g. "shortest solution is exactly 4 moves and every button is needed"
+ */
+
+#ifndef _GENERATOR_HPP
+#define _GENERATOR_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "numeric.hpp"
+#include "solver.hpp"
+
+namespace generator {
+
+	// what a generated level must satisfy
+	struct constraints {
+		int moves; // the shortest solution takes exactly this many presses
+		std::size_t buttons; // how many operations the level has
+		bool unique; // only one press sequence of the shortest length reaches the target
+		bool every_button; // the shortest solution presses every button at least once
+		int max_value; // primary and target stay within +/- this, as the display is only so wide
+	};
+
+	// the most operations a level can have, one per central button of the game
+	const std::size_t max_buttons = 6;
+
+	// randomly pick a set of distinct operations from the default_operation catalogue
+	// count must be at most max_buttons, the catalogue holds far more distinct operations than that
+	std::vector<numeric::opcode> sample_operations(std::mt19937& rng, std::size_t count);
+
+	// build the reachability table of primary for c.moves presses (see solver::reach())
+	// then pick a target from it that meets the constraints
+	// returns false when no number reached by this candidate qualifies
+	bool pick_target(int primary, const std::vector<numeric::opcode>& operations,
+		const constraints& c, std::mt19937& rng, solver::level& out);
+
+	// the level as it would be written in game::levels() of game.cpp
+	// e.g. numeric_level(2, 2, 5, { add(1), add(2) }),
+	std::string as_cpp(const solver::level& l);
+};
+
+#endif // !_GENERATOR_HPP
@@ -0,0 +1,257 @@
+/*
+ * scheduler.cpp:
+ * implements the work stealing pool in scheduler.hpp
+ * the deques are Chase-Lev deques (Le, Pop, Cohen and Zappa Nardelli's weak memory version)
+ */
+
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+	// the pool and worker running on this thread, if any
+	thread_local const scheduler::pool* current_pool = nullptr;
+	thread_local std::size_t current_index = 0;
+
+	// keep the two ends of a deque on separate cache lines
+	// as the owner hammers one and the thieves the other
+	const std::size_t cache_line = 64;
+};
+
+namespace scheduler {
+
+	// a piece of a parallel_for, owned by whichever deque or worker holds the pointer
+	struct pool::task {
+		std::size_t begin, end, grain;
+		const range_function* f;
+		std::atomic<std::size_t>* remaining; // items of the parallel_for not yet done
+	};
+
+	// a fixed size Chase-Lev deque
+	// only the owning worker may push() and pop(), anyone may steal()
+	class pool::deque {
+	public:
+		deque() : _top(0), _bottom(0), _tasks(new std::atomic<task*>[capacity]) {
+			for (std::size_t i = 0; i < capacity; i++)
+				_tasks[i].store(nullptr, std::memory_order_relaxed);
+		}
+
+		// returns false when full, then the owner just runs the task itself
+		bool push(task* t) {
+			long long b = _bottom.load(std::memory_order_relaxed);
+			long long top = _top.load(std::memory_order_acquire);
+
+			if (b - top >= static_cast<long long>(capacity))
+				return false;
+
+			_tasks[b & (capacity - 1)].store(t, std::memory_order_release);
+			std::atomic_thread_fence(std::memory_order_release);
+			_bottom.store(b + 1, std::memory_order_relaxed);
+
+			return true;
+		}
+
+		// the most recently pushed task, or nullptr
+		task* pop() {
+			long long b = _bottom.load(std::memory_order_relaxed) - 1;
+			_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			long long top = _top.load(std::memory_order_relaxed);
+
+			// already empty
+			if (top > b) {
+				_bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			task* t = _tasks[b & (capacity - 1)].load(std::memory_order_acquire);
+
+			// the last task, race any thieves for it
+			if (top == b) {
+				if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					t = nullptr;
+
+				_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+
+			return t;
+		}
+
+		// the least recently pushed task, or nullptr when empty or another thief won
+		task* steal() {
+			long long top = _top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			long long b = _bottom.load(std::memory_order_acquire);
+
+			if (top >= b)
+				return nullptr;
+
+			task* t = _tasks[top & (capacity - 1)].load(std::memory_order_acquire);
+
+			if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+
+			return t;
+		}
+
+	private:
+		// ranges are split in half, so a worker only ever holds about log2(count / grain) tasks
+		static const std::size_t capacity = 1024;
+
+		std::atomic<long long> _top;
+		char _top_pad[cache_line];
+		std::atomic<long long> _bottom;
+		char _bottom_pad[cache_line];
+		std::unique_ptr<std::atomic<task*>[]> _tasks;
+	};
+
+	pool::pool(std::size_t workers) : _running(0), _stop(false) {
+		if (workers == 0)
+			workers = std::max(1u, std::thread::hardware_concurrency());
+
+		for (std::size_t i = 0; i < workers; i++)
+			_deques.emplace_back(new deque());
+
+		// the last worker is whoever calls parallel_for()
+		for (std::size_t i = 0; i + 1 < workers; i++)
+			_threads.emplace_back(&pool::_work, this, i);
+	}
+
+	pool::~pool() {
+		{
+			std::lock_guard<std::mutex> lock(_sleep);
+			_stop = true;
+		}
+
+		_wake.notify_all();
+
+		for (auto& t : _threads)
+			t.join();
+	}
+
+	std::size_t pool::size() const noexcept {
+		return _deques.size();
+	}
+
+	std::size_t pool::worker_index() const noexcept {
+		return (current_pool == this) ? current_index : _deques.size() - 1;
+	}
+
+	void pool::parallel_for(std::size_t count, std::size_t grain, const range_function& f) {
+		if (count == 0)
+			return;
+
+		const pool* outer_pool = current_pool;
+		std::size_t outer_index = current_index;
+		bool nested = (current_pool == this);
+		std::unique_lock<std::mutex> outside;
+
+		// a thread from outside borrows the last worker and wakes everyone else
+		if (!nested) {
+			outside = std::unique_lock<std::mutex>(_outside);
+			current_pool = this;
+			current_index = _deques.size() - 1;
+
+			{
+				std::lock_guard<std::mutex> lock(_sleep);
+				_running++;
+			}
+
+			_wake.notify_all();
+		}
+
+		std::atomic<std::size_t> remaining(count);
+		_run(new task { 0, count, std::max<std::size_t>(grain, 1), &f, &remaining });
+
+		// help with whatever is left rather than block, which also keeps nested calls from deadlocking
+		while (remaining.load(std::memory_order_acquire) > 0) {
+			if (task* t = _find(current_index))
+				_run(t);
+			else
+				std::this_thread::yield();
+		}
+
+		if (!nested) {
+			{
+				std::lock_guard<std::mutex> lock(_sleep);
+				_running--;
+			}
+
+			current_pool = outer_pool;
+			current_index = outer_index;
+		}
+	}
+
+	pool::task* pool::_find(std::size_t index) {
+		if (task* t = _deques[index]->pop())
+			return t;
+
+		// start each sweep at a different victim so thieves don't all pile onto the same deque
+		thread_local std::uint32_t state = 2463534242u ^ static_cast<std::uint32_t>(index * 2654435761u);
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		std::size_t workers = _deques.size();
+		for (std::size_t i = 0, start = state % workers; i < workers; i++) {
+			std::size_t victim = (start + i) % workers;
+
+			if (victim == index)
+				continue;
+
+			if (task* t = _deques[victim]->steal())
+				return t;
+		}
+
+		return nullptr;
+	}
+
+	void pool::_run(task* t) {
+		deque& own = *_deques[current_index];
+
+		// keep the first half and push the second, the biggest halves end up on top for thieves
+		while (t->end - t->begin > t->grain) {
+			std::size_t mid = t->begin + (t->end - t->begin) / 2;
+			task* half = new task(*t);
+			half->begin = mid;
+
+			if (!own.push(half)) {
+				delete half;
+				break;
+			}
+
+			t->end = mid;
+		}
+
+		(*t->f)(t->begin, t->end);
+		t->remaining->fetch_sub(t->end - t->begin, std::memory_order_release);
+
+		delete t;
+	}
+
+	void pool::_work(std::size_t index) {
+		current_pool = this;
+		current_index = index;
+
+		while (true) {
+			if (task* t = _find(index)) {
+				_run(t);
+				continue;
+			}
+
+			// work may still turn up until the last parallel_for returns
+			if (_running.load() > 0) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(_sleep);
+			_wake.wait(lock, [this]() { return _stop || _running.load() > 0; });
+
+			if (_stop)
+				return;
+		}
+	}
+};
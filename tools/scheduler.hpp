@@ -0,0 +1,76 @@
+/*
+ * scheduler.hpp:
+ * a work stealing thread pool for the headless tools
+ * every worker owns a lock free deque, pushing and popping its own work at the bottom
+ * while idle workers steal from the top of someone else's, so the hot path never takes a lock
+ */
+
+#ifndef _SCHEDULER_HPP
+#define _SCHEDULER_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <vector>
+
+namespace scheduler {
+
+	// a body of work over the half open range [begin, end)
+	using range_function = std::function<void(std::size_t begin, std::size_t end)>;
+
+	class pool {
+	public:
+
+		// start workers-1 threads, the thread calling parallel_for() is always the last worker
+		// 0 means one worker per hardware thread
+		explicit pool(std::size_t workers=0);
+
+		// wait for the threads to finish their current work and join them
+		~pool();
+
+		pool(const pool&)=delete;
+		pool& operator=(const pool&)=delete;
+
+		// the number of workers, including the calling thread
+		std::size_t size() const noexcept;
+
+		// call f over [0, count) in pieces of at most grain, returning once every piece is done
+		// ranges are split in half recursively and the halves left for other workers to steal
+		// may be called from within f, but f must not throw
+		void parallel_for(std::size_t count, std::size_t grain, const range_function& f);
+
+		// the index of the worker running the current thread, in [0, size())
+		// lets f keep per-worker state without locking
+		std::size_t worker_index() const noexcept;
+
+	private:
+		struct task;
+		class deque;
+
+		// find the next task: from the bottom of our own deque, then from the top of others
+		task* _find(std::size_t index);
+
+		// run a task, splitting off halves of its range for others to steal
+		void _run(task* t);
+
+		// the loop of every spawned thread
+		void _work(std::size_t index);
+
+		std::vector<std::unique_ptr<deque>> _deques;
+		std::vector<std::thread> _threads;
+
+		// only one thread from outside the pool may use the calling thread's worker at once
+		std::mutex _outside;
+
+		// idle threads sleep here while no parallel_for is running
+		std::mutex _sleep;
+		std::condition_variable _wake;
+		std::atomic<int> _running;
+		bool _stop;
+	};
+};
+
+#endif // !_SCHEDULER_HPP
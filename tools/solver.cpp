@@ -0,0 +1,378 @@
+/*
+ * solver.cpp:
+ * implements the headless level solver in solver.hpp
+ */
+
+#include "solver.hpp"
+#include "state_set.hpp"
+#include "numeric.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+	// marks the starting state, which was not reached by any press
+	const std::size_t no_press = static_cast<std::size_t>(-1);
+
+	// write the lowest bytes of value, least significant first
+	void put(std::ostream& out, std::uint32_t value, int bytes) {
+		for (int b = 0; b < bytes; b++)
+			out.put(static_cast<char>((value >> (8 * b)) & 0xff));
+	}
+};
+
+namespace solver {
+
+	// parse "primary moves target op op ..."
+	level level::from_string(const std::string& s) {
+		std::istringstream in(s);
+		std::vector<std::string> words;
+
+		for (std::string w; in >> w;)
+			words.push_back(w);
+
+		if (words.size() < 4)
+			throw std::invalid_argument("expected 'primary moves target op...' got: " + s);
+
+		level l;
+		l.primary = numeric::from_string(words[0]);
+		l.moves = numeric::from_string(words[1]);
+		l.target = numeric::from_string(words[2]);
+
+		for (std::size_t i = 3; i < words.size(); i++)
+			l.operations.push_back(numeric::opcode::from_string(words[i]));
+
+		return l;
+	}
+
+	// the inverse of from_string()
+	std::string level::get_string() const {
+		std::string ret = std::to_string(primary) + " " + std::to_string(moves) + " " + std::to_string(target);
+
+		for (const auto& op : operations)
+			ret += " " + op.get_string();
+
+		return ret;
+	}
+
+	// the button strings pressed
+	std::string solution::get_string(const level& l) const {
+		std::string ret;
+
+		for (auto p : presses)
+			ret += (ret.empty() ? "" : " ") + l.operations[p].get_string();
+
+		return ret;
+	}
+
+	// the entry for value, or nullptr when it can't be reached
+	const reachable* table::find(int value) const {
+		for (const auto& r : entries)
+			if (r.value == value)
+				return &r;
+
+		return nullptr;
+	}
+
+	// walk back along parents to the start then flip into press order
+	std::vector<std::size_t> table::witness(std::size_t entry) const {
+		std::vector<std::size_t> ret;
+
+		for (auto at = entry; entries[at].moves > 0; at = entries[at].parent)
+			ret.push_back(entries[at].press);
+
+		std::reverse(ret.begin(), ret.end());
+		return ret;
+	}
+
+	void table::write_csv(std::ostream& out) const {
+		out << "value,moves,paths,presses\n";
+
+		for (std::size_t e = 0; e < entries.size(); e++) {
+			const auto& r = entries[e];
+			out << r.value << "," << r.moves << "," << static_cast<int>(r.paths) << ",";
+
+			std::string presses;
+			for (auto p : witness(e))
+				presses += (presses.empty() ? "" : " ") + operations[p].get_string();
+
+			out << presses << "\n";
+		}
+	}
+
+	void table::write_binary(std::ostream& out) const {
+		out.write("CRT1", 4);
+		put(out, static_cast<std::uint32_t>(primary), 4);
+		put(out, static_cast<std::uint32_t>(moves), 4);
+		put(out, static_cast<std::uint32_t>(operations.size()), 4);
+
+		for (const auto& op : operations) {
+			put(out, static_cast<std::uint32_t>(op.type), 1);
+			put(out, static_cast<std::uint32_t>(op.n), 4);
+		}
+
+		put(out, static_cast<std::uint32_t>(entries.size()), 4);
+
+		for (const auto& r : entries) {
+			put(out, static_cast<std::uint32_t>(r.value), 4);
+			put(out, static_cast<std::uint32_t>(r.parent), 4);
+			put(out, static_cast<std::uint32_t>(r.moves), 2);
+			put(out, static_cast<std::uint32_t>(r.press), 1);
+			put(out, r.paths, 1);
+		}
+	}
+
+	// breadth first search from primary, one layer per move, counting the shortest paths to everything
+	table reach(int primary, int moves, const std::vector<operation>& operations) {
+		table t;
+		reach(primary, moves, operations, t);
+
+		return t;
+	}
+
+	void reach(int primary, int moves, const std::vector<operation>& operations, table& t) {
+		t.primary = primary;
+		t.moves = moves;
+		t.operations = operations;
+		t.entries.assign(1, reachable { primary, 0, 0, 0, 1 });
+
+		// every visited number mapped to its entry, reused between calls
+		// as the generator builds a table for millions of candidates and would otherwise spend most of its time allocating
+		thread_local std::unordered_map<int, std::size_t> seen;
+		thread_local std::vector<int> frontier, results;
+		thread_local std::vector<std::uint8_t> ok;
+
+		seen.clear();
+		seen.emplace(primary, 0);
+
+		// the layer being pressed is entries [begin, end)
+		for (std::size_t begin = 0, end = 1; begin < end && t.entries[begin].moves < moves; begin = end, end = t.entries.size()) {
+			int depth = t.entries[begin].moves;
+
+			frontier.resize(end - begin);
+			results.resize(end - begin);
+			ok.resize(end - begin);
+
+			for (std::size_t f = 0; f < frontier.size(); f++)
+				frontier[f] = t.entries[begin + f].value;
+
+			for (std::size_t i = 0; i < operations.size(); i++) {
+				numeric::apply_batch(operations[i], frontier.data(), results.data(), ok.data(), frontier.size());
+
+				for (std::size_t f = 0; f < frontier.size(); f++) {
+					if (!ok[f])
+						continue;
+
+					// every path into the layer being pressed was counted while building it
+					std::uint8_t paths = t.entries[begin + f].paths;
+					auto found = seen.emplace(results[f], t.entries.size());
+
+					// reached again within the same layer: another shortest path
+					if (found.second)
+						t.entries.push_back(reachable { results[f], depth + 1, begin + f, i, paths });
+					else if (t.entries[found.first->second].moves == depth + 1)
+						t.entries[found.first->second].paths = std::min(2, t.entries[found.first->second].paths + paths);
+				}
+			}
+		}
+	}
+
+	// breadth first search from primary, one layer per move
+	// only which numbers each layer reached is kept, in compact state sets
+	// and the presses are recovered afterwards by stepping back through the layers
+	solution bfs(const level& l) {
+		solution s { false, {}, 0 };
+
+		state_set seen;
+		std::vector<state_set> layers(1);
+		std::vector<int> frontier { l.primary }, next, results, pre;
+		std::vector<std::uint8_t> ok;
+		int last = l.primary; // the number the final press was made on
+
+		seen.insert(l.primary);
+		layers[0].insert(l.primary);
+
+		for (int depth = 0; depth < l.moves && !frontier.empty() && !s.solved; depth++) {
+			next.clear();
+			results.resize(frontier.size());
+			ok.resize(frontier.size());
+			layers.emplace_back();
+
+			// press each button on the whole frontier at once
+			for (std::size_t i = 0; i < l.operations.size() && !s.solved; i++) {
+				numeric::apply_batch(l.operations[i], frontier.data(), results.data(), ok.data(), frontier.size());
+
+				for (std::size_t f = 0; f < frontier.size(); f++) {
+					int out = results[f];
+
+					// an ERR! is a dead end
+					if (!ok[f])
+						continue;
+
+					// the target is checked before the visited set
+					// because a level may start on its own target
+					if (out == l.target) {
+						s.solved = true;
+						s.presses.push_back(i);
+						last = frontier[f];
+						break;
+					}
+
+					if (seen.insert(out)) {
+						layers.back().insert(out);
+						next.push_back(out);
+					}
+				}
+			}
+
+			std::swap(frontier, next);
+		}
+
+		// last is in the layer before the one being built, and some number in the layer before that
+		// leads to it with one press: found through preimages when the button has them, otherwise by pressing every number
+		for (int layer = static_cast<int>(layers.size()) - 2; s.solved && layer > 0; layer--) {
+			bool found = false;
+
+			for (std::size_t i = 0; i < l.operations.size() && !found; i++) {
+				const auto& op = l.operations[i];
+
+				if (op.invertible()) {
+					pre.clear();
+					op.preimages(last, pre);
+
+					for (int in : pre) {
+						if (!found && layers[layer - 1].contains(in)) {
+							found = true;
+							s.presses.push_back(i);
+							last = in;
+						}
+					}
+				} else {
+					int from = last;
+
+					layers[layer - 1].for_each([&](int in) {
+						int out;
+						if (!found && op.apply(in, out) && out == from) {
+							found = true;
+							s.presses.push_back(i);
+							last = in;
+						}
+					});
+				}
+			}
+		}
+
+		std::reverse(s.presses.begin(), s.presses.end());
+
+		s.expanded = seen.size();
+		return s;
+	}
+
+	// breadth first search from both ends, meeting in the middle
+	solution bidirectional(const level& l) {
+
+		// preimages can't be enumerated, or the level starts on its own target
+		// which still needs at least one press that a meet at depth zero would skip
+		for (const auto& op : l.operations)
+			if (!op.invertible())
+				return bfs(l);
+
+		if (l.primary == l.target)
+			return bfs(l);
+
+		solution s { false, {}, 0 };
+
+		// every visited state mapped to its neighbour towards the root of that side
+		// the button pressed between them and its distance from the root
+		struct link {
+			int via;
+			std::size_t press;
+			int depth;
+		};
+
+		std::unordered_map<int, link> forward, backward;
+		std::vector<int> forward_frontier { l.primary }, backward_frontier { l.target }, next, pre, results;
+		std::vector<std::uint8_t> ok;
+		int forward_depth = 0, backward_depth = 0, meet = 0, best = 0;
+
+		forward.emplace(l.primary, link { l.primary, no_press, 0 });
+		backward.emplace(l.target, link { l.target, no_press, 0 });
+
+		// expand one whole layer at a time so that the first layer with any meet
+		// holds the shortest path, which is the cheapest meet found within it
+		while (!s.solved && forward_depth + backward_depth < l.moves
+			&& !forward_frontier.empty() && !backward_frontier.empty()) {
+			next.clear();
+
+			if (forward_frontier.size() <= backward_frontier.size()) {
+				results.resize(forward_frontier.size());
+				ok.resize(forward_frontier.size());
+
+				for (std::size_t i = 0; i < l.operations.size(); i++) {
+					numeric::apply_batch(l.operations[i], forward_frontier.data(), results.data(), ok.data(), forward_frontier.size());
+
+					for (std::size_t f = 0; f < forward_frontier.size(); f++) {
+						int out = results[f];
+						if (!ok[f] || !forward.emplace(out, link { forward_frontier[f], i, forward_depth + 1 }).second)
+							continue;
+
+						next.push_back(out);
+
+						auto other = backward.find(out);
+						if (other != backward.end() && (!s.solved || forward_depth + 1 + other->second.depth < best)) {
+							s.solved = true;
+							meet = out;
+							best = forward_depth + 1 + other->second.depth;
+						}
+					}
+				}
+
+				forward_depth++;
+				std::swap(forward_frontier, next);
+			} else {
+				for (int on : backward_frontier) {
+					for (std::size_t i = 0; i < l.operations.size(); i++) {
+						pre.clear();
+						l.operations[i].preimages(on, pre);
+
+						for (int in : pre) {
+							if (!backward.emplace(in, link { on, i, backward_depth + 1 }).second)
+								continue;
+
+							next.push_back(in);
+
+							auto other = forward.find(in);
+							if (other != forward.end() && (!s.solved || backward_depth + 1 + other->second.depth < best)) {
+								s.solved = true;
+								meet = in;
+								best = backward_depth + 1 + other->second.depth;
+							}
+						}
+					}
+				}
+
+				backward_depth++;
+				std::swap(backward_frontier, next);
+			}
+		}
+
+		if (s.solved) {
+
+			// walk back to primary then flip into press order
+			for (auto at = forward.find(meet); at->second.press != no_press; at = forward.find(at->second.via))
+				s.presses.push_back(at->second.press);
+
+			std::reverse(s.presses.begin(), s.presses.end());
+
+			// then walk on towards target, already in press order
+			for (auto at = backward.find(meet); at->second.press != no_press; at = backward.find(at->second.via))
+				s.presses.push_back(at->second.press);
+		}
+
+		s.expanded = forward.size() + backward.size();
+		return s;
+	}
+};
@@ -0,0 +1,102 @@
+/*
+ * solver.hpp:
+ * a headless level solver, finds the shortest sequence of button presses
+ * that takes a level's primary number to its target without ever touching SFML
+ */
+
+#ifndef _SOLVER_HPP
+#define _SOLVER_HPP
+
+#include <stdexcept>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "numeric.hpp"
+
+namespace solver {
+
+	// a numeric button the solver may press
+	using operation = numeric::opcode;
+
+	// the numeric part of a level in game.cpp
+	// e.g. numeric_level(2, 2, 5, { add(1), add(2) })
+	struct level {
+		int primary, moves, target;
+		std::vector<operation> operations;
+
+		// parse "primary moves target op op ..."
+		// e.g. "2 2 5 +1 +2", throws std::invalid_argument on garbage
+		static level from_string(const std::string& s);
+
+		// the inverse of from_string()
+		std::string get_string() const;
+	};
+
+	// the result of a search
+	struct solution {
+		bool solved;
+		std::vector<std::size_t> presses; // indices into level::operations, in order
+		std::size_t expanded; // number of distinct states visited
+
+		// the button strings pressed e.g. "+1 +2"
+		std::string get_string(const level& l) const;
+	};
+
+	// a number reachable from the start of a table
+	struct reachable {
+		int value;
+		int moves; // fewest presses from the start, 0 for the start itself
+		std::size_t parent; // the entry pressed to get here along one shortest path
+		std::size_t press; // the button pressed from parent, meaningless for the start
+		std::uint8_t paths; // shortest press sequences to here, saturating at 2
+	};
+
+	// every number reachable from one start within a move budget
+	// answers "which targets can this set of buttons make" with one search instead of one per target
+	struct table {
+		int primary, moves;
+		std::vector<operation> operations;
+
+		// in the order the search reached them, the start first
+		// so each move count is a contiguous run and every parent comes before its children
+		std::vector<reachable> entries;
+
+		// the entry for value, or nullptr when it can't be reached
+		// a linear scan, walk entries directly when looking at more than a few values
+		const reachable* find(int value) const;
+
+		// the presses along one shortest path from primary to entries[entry]
+		// indices into operations in order, empty for the start
+		std::vector<std::size_t> witness(std::size_t entry) const;
+
+		// one "value,moves,paths,presses" line per entry under a header line
+		// presses are button strings e.g. 5,2,1,+1 +2
+		void write_csv(std::ostream& out) const;
+
+		// the same in little endian binary:
+		// "CRT1", int32 primary, int32 moves, uint32 button count
+		// then per button uint8 numeric::opcode::kind and int32 n
+		// then uint32 entry count and per entry int32 value, uint32 parent, uint16 moves, uint8 press, uint8 paths
+		void write_binary(std::ostream& out) const;
+	};
+
+	// breadth first search from primary for up to moves presses, keeping everything reached
+	table reach(int primary, int moves, const std::vector<operation>& operations);
+
+	// the same into an existing table, reusing its memory when building many tables in a row
+	void reach(int primary, int moves, const std::vector<operation>& operations, table& out);
+
+	// breadth first search from primary
+	// the first path found to target is the shortest, if none is found
+	// within the move budget then the level cannot be solved
+	solution bfs(const level& l);
+
+	// breadth first search from primary and backwards from target using preimages
+	// expanding whichever frontier is smaller until the two meet in the middle
+	// falls back to bfs() when an operation is not invertible
+	solution bidirectional(const level& l);
+};
+
+#endif // !_SOLVER_HPP
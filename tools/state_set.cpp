@@ -0,0 +1,179 @@
+/*
+ * state_set.cpp:
+ * implements the compact state set in state_set.hpp
+ */
+
+#include "state_set.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace solver {
+
+	state_set::state_set() : _size(0), _last(0) {
+
+	}
+
+	bool state_set::insert(int value) {
+		std::uint32_t key = to_key(value);
+		chunk& c = _get(static_cast<std::uint16_t>(key >> 16));
+		std::uint16_t low = static_cast<std::uint16_t>(key);
+
+		if (c.bits.empty()) {
+			auto at = std::lower_bound(c.array.begin(), c.array.end(), low);
+			if (at != c.array.end() && *at == low)
+				return false;
+
+			c.array.insert(at, low);
+			c.count++;
+			_size++;
+
+			if (c.count > array_limit)
+				_to_bitmap(c);
+
+			return true;
+		}
+
+		std::uint64_t& word = c.bits[low >> 6];
+		std::uint64_t bit = std::uint64_t(1) << (low & 63);
+
+		if (word & bit)
+			return false;
+
+		word |= bit;
+		c.count++;
+		_size++;
+
+		return true;
+	}
+
+	bool state_set::contains(int value) const {
+		std::uint32_t key = to_key(value);
+		const chunk* c = _find(static_cast<std::uint16_t>(key >> 16));
+		std::uint16_t low = static_cast<std::uint16_t>(key);
+
+		if (!c)
+			return false;
+
+		if (c->bits.empty())
+			return std::binary_search(c->array.begin(), c->array.end(), low);
+
+		return (c->bits[low >> 6] >> (low & 63)) & 1;
+	}
+
+	void state_set::merge(const state_set& other) {
+		for (const auto& from : other._chunks) {
+			chunk& to = _get(from.key);
+			_size -= to.count;
+
+			// at least one bitmap: or the other in
+			if (!from.bits.empty() || !to.bits.empty()) {
+				if (to.bits.empty())
+					_to_bitmap(to);
+
+				if (from.bits.empty()) {
+					for (auto low : from.array)
+						to.bits[low >> 6] |= std::uint64_t(1) << (low & 63);
+				} else {
+					for (std::size_t w = 0; w < bitmap_words; w++)
+						to.bits[w] |= from.bits[w];
+				}
+
+				to.count = 0;
+				for (auto word : to.bits)
+					to.count += bit_count(word);
+			}
+
+			// two arrays: merge them, becoming a bitmap if the result is too big
+			else {
+				std::vector<std::uint16_t> both;
+				both.reserve(to.array.size() + from.array.size());
+				std::set_union(to.array.begin(), to.array.end(), from.array.begin(), from.array.end(), std::back_inserter(both));
+
+				to.array.swap(both);
+				to.count = static_cast<std::uint32_t>(to.array.size());
+
+				if (to.count > array_limit)
+					_to_bitmap(to);
+			}
+
+			_size += to.count;
+		}
+	}
+
+	void state_set::clear() noexcept {
+		_chunks.clear();
+		_index.clear();
+		_size = 0;
+		_last = 0;
+	}
+
+	std::size_t state_set::size() const noexcept {
+		return _size;
+	}
+
+	bool state_set::empty() const noexcept {
+		return _size == 0;
+	}
+
+	std::size_t state_set::memory() const noexcept {
+		std::size_t ret = _chunks.capacity() * sizeof(chunk) + _index.capacity() * sizeof(std::int32_t);
+
+		for (const auto& c : _chunks)
+			ret += c.array.capacity() * sizeof(std::uint16_t) + c.bits.capacity() * sizeof(std::uint64_t);
+
+		return ret;
+	}
+
+	const state_set::chunk* state_set::_find(std::uint16_t key) const {
+		if (_last < _chunks.size() && _chunks[_last].key == key)
+			return &_chunks[_last];
+
+		if (!_index.empty()) {
+			if (_index[key] < 0)
+				return nullptr;
+
+			_last = _index[key];
+			return &_chunks[_last];
+		}
+
+		for (std::size_t i = 0; i < _chunks.size(); i++) {
+			if (_chunks[i].key == key) {
+				_last = i;
+				return &_chunks[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	state_set::chunk& state_set::_get(std::uint16_t key) {
+		if (const chunk* c = _find(key))
+			return _chunks[c - _chunks.data()];
+
+		_last = _chunks.size();
+		_chunks.push_back(chunk { key, 0, {}, {} });
+
+		if (!_index.empty())
+			_index[key] = static_cast<std::int32_t>(_last);
+
+		// too many chunks to scan, index every one
+		else if (_chunks.size() > scan_limit) {
+			_index.assign(65536, -1);
+
+			for (std::size_t i = 0; i < _chunks.size(); i++)
+				_index[_chunks[i].key] = static_cast<std::int32_t>(i);
+		}
+
+		return _chunks[_last];
+	}
+
+	void state_set::_to_bitmap(chunk& c) {
+		c.bits.assign(bitmap_words, 0);
+
+		for (auto low : c.array)
+			c.bits[low >> 6] |= std::uint64_t(1) << (low & 63);
+
+		std::vector<std::uint16_t>().swap(c.array);
+	}
+};
@@ -0,0 +1,125 @@
+/*
+ * state_set.hpp:
+ * a compact set of ints for the visited states of a search
+ * the 32 bit value space is split into 65536 chunks of 65536 values (as in roaring bitmaps)
+ * a chunk holding few values is a sorted array of their low 16 bits, 2 bytes each
+ * and becomes a 8KiB bitmap once that would be smaller
+ * so a chunk costs at most 2 bytes a value and 8KiB, on top of a small fixed overhead
+ */
+
+#ifndef _STATE_SET_HPP
+#define _STATE_SET_HPP
+
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace solver {
+
+	class state_set {
+	public:
+		state_set();
+
+		// returns true when value was not already in the set
+		bool insert(int value);
+
+		bool contains(int value) const;
+
+		// add every value of other (set union)
+		void merge(const state_set& other);
+
+		void clear() noexcept;
+
+		std::size_t size() const noexcept;
+		bool empty() const noexcept;
+
+		// bytes held by the set, excluding sizeof(state_set)
+		std::size_t memory() const noexcept;
+
+		// call f(value) for every value, chunk by chunk in the order they were first used
+		template <typename F>
+		void for_each(F f) const {
+			for (const auto& c : _chunks) {
+				std::uint32_t high = static_cast<std::uint32_t>(c.key) << 16;
+
+				if (c.bits.empty()) {
+					for (auto low : c.array)
+						f(from_key(high | low));
+				} else {
+					for (std::size_t w = 0; w < c.bits.size(); w++) {
+						for (std::uint64_t word = c.bits[w]; word; word &= word - 1)
+							f(from_key(high | static_cast<std::uint32_t>(w * 64 + lowest_bit(word))));
+					}
+				}
+			}
+		}
+
+	private:
+
+		// a 65536 value slice of the set
+		// array while count <= array_limit, otherwise bits
+		struct chunk {
+			std::uint16_t key; // the high 16 bits of every value in it
+			std::uint32_t count;
+			std::vector<std::uint16_t> array; // sorted low 16 bits
+			std::vector<std::uint64_t> bits;
+		};
+
+		// past this many values an array takes more room than a bitmap
+		static const std::uint32_t array_limit = 4096;
+		static const std::size_t bitmap_words = 65536 / 64;
+
+		// past this many chunks they are found through _index rather than a scan
+		static const std::size_t scan_limit = 16;
+
+		// ints mapped onto unsigned keys in the same order, so iteration within a chunk is ascending
+		static std::uint32_t to_key(int value) noexcept {
+			return static_cast<std::uint32_t>(value) ^ 0x80000000u;
+		}
+
+		static int from_key(std::uint32_t key) noexcept {
+			return static_cast<int>(key ^ 0x80000000u);
+		}
+
+		// the index of the lowest set bit of a non zero word
+		static unsigned int lowest_bit(std::uint64_t word) noexcept {
+#if defined(_MSC_VER)
+			unsigned long ret;
+			_BitScanForward64(&ret, word);
+			return static_cast<unsigned int>(ret);
+#else
+			return static_cast<unsigned int>(__builtin_ctzll(word));
+#endif
+		}
+
+		// the number of set bits in word
+		static std::uint32_t bit_count(std::uint64_t word) noexcept {
+#if defined(_MSC_VER)
+			return static_cast<std::uint32_t>(__popcnt64(word));
+#else
+			return static_cast<std::uint32_t>(__builtin_popcountll(word));
+#endif
+		}
+
+		// the chunk for the high 16 bits of a key, or nullptr
+		const chunk* _find(std::uint16_t key) const;
+
+		// the chunk for the high 16 bits of a key, created if need be
+		chunk& _get(std::uint16_t key);
+
+		// switch a full array chunk over to a bitmap
+		static void _to_bitmap(chunk& c);
+
+		std::vector<chunk> _chunks; // in the order they were first used
+		std::vector<std::int32_t> _index; // the chunk of every key, or -1, empty until there are scan_limit chunks
+		std::size_t _size;
+
+		// the last chunk probed, as consecutive probes usually land in the same one
+		mutable std::size_t _last;
+	};
+};
+
+#endif // !_STATE_SET_HPP
@@ -0,0 +1,115 @@
+/*
+ * validate.cpp:
+ * implements the solution checks and frames in validate.hpp
+ */
+
+#include "validate.hpp"
+
+namespace {
+
+	// write the lowest bytes of value, least significant first
+	void put(std::string& out, std::uint32_t value, int bytes) {
+		for (int b = 0; b < bytes; b++)
+			out.push_back(static_cast<char>((value >> (8 * b)) & 0xff));
+	}
+
+	// read a little endian number that is bytes long
+	std::uint32_t get(const char* in, int bytes) {
+		std::uint32_t ret = 0;
+
+		for (int b = 0; b < bytes; b++)
+			ret |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[b])) << (8 * b);
+
+		return ret;
+	}
+};
+
+namespace validate {
+
+	std::string get_string(verdict v) {
+		switch (v) {
+			case verdict::playing: return "PLAYING";
+			case verdict::win: return "WIN";
+			case verdict::lose: return "LOSE";
+			case verdict::err: return "ERR";
+			case verdict::invalid: return "INVALID";
+		}
+
+		return "";
+	}
+
+	void batch::clear() {
+		ids.clear();
+		levels.clear();
+		offsets.assign(1, 0);
+		presses.clear();
+		verdicts.clear();
+	}
+
+	void batch::push(std::uint32_t id, std::uint16_t level, const std::uint8_t* p, std::size_t count) {
+		ids.push_back(id);
+		levels.push_back(level);
+		presses.insert(presses.end(), p, p + count);
+		offsets.push_back(static_cast<std::uint32_t>(presses.size()));
+		verdicts.push_back(verdict::playing);
+	}
+
+	std::size_t batch::parse(const char* data, std::size_t size, std::size_t max) {
+		std::size_t at = 0;
+
+		for (std::size_t n = 0; n < max && size - at >= request_header; n++) {
+			std::size_t count = get(data + at + 6, 2);
+
+			if (size - at < request_header + count)
+				break;
+
+			push(get(data + at, 4), static_cast<std::uint16_t>(get(data + at + 4, 2)),
+				reinterpret_cast<const std::uint8_t*>(data + at + request_header), count);
+
+			at += request_header + count;
+		}
+
+		return at;
+	}
+
+	void batch::write_requests(std::string& out) const {
+		for (std::size_t i = 0; i < size(); i++) {
+			put(out, ids[i], 4);
+			put(out, levels[i], 2);
+			put(out, offsets[i + 1] - offsets[i], 2);
+			out.append(reinterpret_cast<const char*>(presses.data() + offsets[i]), offsets[i + 1] - offsets[i]);
+		}
+	}
+
+	void batch::write_responses(std::string& out) const {
+		for (std::size_t i = 0; i < size(); i++) {
+			put(out, ids[i], 4);
+			put(out, static_cast<std::uint32_t>(verdicts[i]), 1);
+		}
+	}
+
+	// play the presses exactly as the game would, see numeric_operation::call
+	void check(game::session& s, batch& b, std::size_t i) {
+		if (b.levels[i] >= game::levels().size() || game::levels()[b.levels[i]].is_tutorial()) {
+			b.verdicts[i] = verdict::invalid;
+			return;
+		}
+
+		s.go(b.levels[i]);
+		s.start();
+
+		std::size_t buttons = s.current().operations.size();
+		game::verdict v = game::verdict::playing;
+
+		for (std::size_t p = b.offsets[i]; p < b.offsets[i + 1]; p++) {
+			if (b.presses[p] >= buttons) {
+				b.verdicts[i] = verdict::invalid;
+				return;
+			}
+
+			v = s.press(static_cast<std::size_t>(b.presses[p]));
+		}
+
+		b.verdicts[i] = static_cast<verdict>(v);
+	}
+};
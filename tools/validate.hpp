@@ -0,0 +1,69 @@
+/*
+ * validate.hpp:
+ * check player submitted solutions with the rules of the game (see game::session)
+ * and the little endian binary frames they are sent and answered in:
+ * request:  uint32 id, uint16 level, uint16 count, then count uint8 button indices
+ * response: uint32 id, uint8 verdict (see verdict below)
+ */
+
+#ifndef _VALIDATE_HPP
+#define _VALIDATE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game.hpp"
+
+namespace validate {
+
+	// bytes before the presses of a request, and of a whole response
+	const std::size_t request_header = 8;
+	const std::size_t response_size = 5;
+
+	// the answer to a request
+	// the first four are game::verdict, so a level still being played after the last press is playing
+	enum class verdict : std::uint8_t {
+		playing,
+		win,
+		lose,
+		err,
+		invalid // no such numeric level, or a button it doesn't have
+	};
+
+	// "PLAYING", "WIN", "LOSE", "ERR" or "INVALID"
+	std::string get_string(verdict v);
+
+	// many requests stored flat, so a batch is reused without allocating per request
+	struct batch {
+		std::vector<std::uint32_t> ids;
+		std::vector<std::uint16_t> levels;
+		std::vector<std::uint32_t> offsets; // the presses of request i are [offsets[i], offsets[i + 1])
+		std::vector<std::uint8_t> presses;
+		std::vector<verdict> verdicts; // one per request, filled in by check()
+
+		batch() : offsets(1, 0) { }
+
+		std::size_t size() const noexcept { return ids.size(); }
+		void clear();
+
+		// append a request
+		void push(std::uint32_t id, std::uint16_t level, const std::uint8_t* presses, std::size_t count);
+
+		// append the whole frames at the start of [data, data + size), at most max of them
+		// returns the bytes used, anything after is an incomplete frame
+		std::size_t parse(const char* data, std::size_t size, std::size_t max);
+
+		// append the request frames of every request to out
+		void write_requests(std::string& out) const;
+
+		// append the response frames of every request to out, once checked
+		void write_responses(std::string& out) const;
+	};
+
+	// start a level in s, press every button of request i and store its verdict
+	// s is reset by every call, so one session serves any number of requests
+	void check(game::session& s, batch& b, std::size_t i);
+};
+
+#endif // !_VALIDATE_HPP